@@ -0,0 +1,86 @@
+#include "arena.h"
+#include <cstdlib>
+#include <mutex>
+
+namespace {
+
+// 进程内共享的空闲内存块池，超出上限的块直接归还系统
+struct ChunkPool {
+    static const size_t kMaxChunks = 1024;  // 64MB
+
+    std::mutex mutex;
+    std::vector<char*> chunks;
+
+    ~ChunkPool() {
+        for (char* chunk : chunks) {
+            std::free(chunk);
+        }
+    }
+};
+
+ChunkPool& chunkPool() {
+    static ChunkPool pool;
+    return pool;
+}
+
+} // namespace
+
+void* AstArena::allocateSlow(size_t size, size_t align) {
+    char* chunk = nullptr;
+    size_t chunkSize = kChunkSize;
+    if (size + align > kChunkSize) {
+        // 超过块大小的对象单独占用一块
+        chunkSize = size + align;
+        chunk = static_cast<char*>(std::malloc(chunkSize));
+        if (!chunk) {
+            throw std::bad_alloc();
+        }
+        largeChunks.push_back(chunk);
+    } else {
+        ChunkPool& pool = chunkPool();
+        {
+            std::lock_guard<std::mutex> lock(pool.mutex);
+            if (!pool.chunks.empty()) {
+                chunk = pool.chunks.back();
+                pool.chunks.pop_back();
+            }
+        }
+        if (!chunk) {
+            chunk = static_cast<char*>(std::malloc(chunkSize));
+            if (!chunk) {
+                throw std::bad_alloc();
+            }
+        }
+        chunks.push_back(chunk);
+    }
+    cursor = chunk;
+    limit = chunk + chunkSize;
+    return allocate(size, align);
+}
+
+void AstArena::release() {
+    // 逆序析构：后创建的节点可能引用先创建的节点
+    for (size_t i = destructors.size(); i > 0; i--) {
+        destructors[i - 1].destroy(destructors[i - 1].object);
+    }
+    destructors.clear();
+    if (!chunks.empty()) {
+        ChunkPool& pool = chunkPool();
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        for (char* chunk : chunks) {
+            if (pool.chunks.size() < ChunkPool::kMaxChunks) {
+                pool.chunks.push_back(chunk);
+            } else {
+                std::free(chunk);
+            }
+        }
+    }
+    chunks.clear();
+    for (char* chunk : largeChunks) {
+        std::free(chunk);
+    }
+    largeChunks.clear();
+    cursor = nullptr;
+    limit = nullptr;
+    bytesUsed = 0;
+}
@@ -0,0 +1,70 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// AST内存池：节点在大块内存中顺序（bump）分配，整棵树随内存池一起释放。
+// 节点之间以裸指针相连，不再逐个delete；只有带非平凡析构的类型
+// （仍含std::string/std::vector成员的节点）会登记析构函数，释放时顺序调用，
+// 不需要沿树递归，其余节点随内存块整体归还。
+// 归还的标准大小内存块放入进程内共享的空闲池（有上限），之后的编译（批量模式中的其他文件、
+// 服务模式中的后续请求）直接取用，不必重新向系统申请。
+class AstArena {
+private:
+    struct Destructor {
+        void (*destroy)(void*);
+        void* object;
+    };
+
+    std::vector<char*> chunks;          // 已分配的标准大小内存块
+    std::vector<char*> largeChunks;     // 超过标准大小、单独分配的内存块
+    char* cursor;                       // 当前块中下一个可用位置
+    char* limit;                        // 当前块末尾
+    size_t bytesUsed;                   // 已分配给节点的字节数
+    std::vector<Destructor> destructors;
+
+    static const size_t kChunkSize = 64 * 1024;
+
+    void* allocateSlow(size_t size, size_t align);
+
+    template<typename T>
+    static void destroy(void* object) { static_cast<T*>(object)->~T(); }
+
+public:
+    AstArena() : cursor(nullptr), limit(nullptr), bytesUsed(0) {}
+    ~AstArena() { release(); }
+    AstArena(const AstArena&) = delete;
+    AstArena& operator=(const AstArena&) = delete;
+
+    void* allocate(size_t size, size_t align) {
+        size_t padding = (align - reinterpret_cast<size_t>(cursor) % align) % align;
+        if (cursor && padding + size <= static_cast<size_t>(limit - cursor)) {
+            void* result = cursor + padding;
+            cursor += padding + size;
+            bytesUsed += size;
+            return result;
+        }
+        return allocateSlow(size, align);
+    }
+
+    // 在内存池中构造节点
+    template<typename T, typename... Args>
+    T* make(Args&&... args) {
+        T* object = new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+        if (!std::is_trivially_destructible<T>::value) {
+            destructors.push_back({&AstArena::destroy<T>, object});
+        }
+        return object;
+    }
+
+    // 析构登记的对象并归还全部内存块
+    void release();
+
+    size_t used() const { return bytesUsed; }
+};
+
+#endif // ARENA_H
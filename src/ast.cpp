@@ -1,6 +1,30 @@
 #include "ast.h"
 #include <iomanip>
 
+const std::string& symbolKindName(SymbolKind kind) {
+    static const std::string kNames[] = {"", "variable", "parameter", "function", "literal", "expression"};
+    return kNames[static_cast<int>(kind)];
+}
+
+const std::string& opSpelling(BinaryOp op) {
+    static const std::string kSpellings[] = {
+        "+", "-", "*", "/", "%", "<<", ">>", "&",
+        "==", "!=", "<", ">", "<=", ">=",
+        "&&", "||"
+    };
+    return kSpellings[static_cast<int>(op)];
+}
+
+const std::string& opSpelling(UnaryOp op) {
+    static const std::string kSpellings[] = {"-", "!"};
+    return kSpellings[static_cast<int>(op)];
+}
+
+const std::string& nodeErrorMessage(NodeError error) {
+    static const std::string kMessages[] = {"", "未声明的标识符", "无效的二元运算"};
+    return kMessages[static_cast<int>(error)];
+}
+
 // 辅助函数：打印缩进
 void printIndent(int indent) {
     for (int i = 0; i < indent; ++i) {
@@ -245,13 +269,13 @@ void Program::print(int indent) const {
 
 // 辅助函数：打印语义信息
 void printSemanticInfo(const SemanticInfo& info, int indent) {
-    if (!info.type.empty() || info.hasSemanticError || !info.symbolKind.empty()) {
+    if (info.type != TypeKind::None || info.hasSemanticError() || info.symbolKind != SymbolKind::None) {
         printIndent(indent);
         std::cerr << "[语义信息: ";
-        if (!info.type.empty()) {
+        if (info.type != TypeKind::None) {
             std::cerr << "类型=" << info.type << " ";
         }
-        if (!info.symbolKind.empty()) {
+        if (info.symbolKind != SymbolKind::None) {
             std::cerr << "种类=" << info.symbolKind << " ";
         }
         if (info.scopeLevel > 0) {
@@ -260,8 +284,8 @@ void printSemanticInfo(const SemanticInfo& info, int indent) {
         if (info.isInitialized) {
             std::cerr << "已初始化 ";
         }
-        if (info.hasSemanticError) {
-            std::cerr << "错误: " << info.errorMessage << " ";
+        if (info.hasSemanticError()) {
+            std::cerr << "错误: " << nodeErrorMessage(info.error) << " ";
         }
         std::cerr << "]" << std::endl;
     }
@@ -1,49 +1,101 @@
 #ifndef AST_H
 #define AST_H
 
+#include "arena.h"
+#include "intern.h"
+#include "types.h"
 #include <string>
 #include <vector>
-#include <memory>
 #include <iostream>
 
 // 前向声明
 class Visitor;
 
-// 语义信息结构
+// 符号种类
+enum class SymbolKind : unsigned char {
+    None, Variable, Parameter, Function, Literal, Expression
+};
+
+// 二元运算符（Shl、Sar、BitAnd 只由常量折叠的强度削减产生）
+enum class BinaryOp : unsigned char {
+    Add, Sub, Mul, Div, Mod, Shl, Sar, BitAnd,
+    Eq, Ne, Lt, Gt, Le, Ge,
+    LogicalAnd, LogicalOr
+};
+
+// 一元运算符
+enum class UnaryOp : unsigned char {
+    Neg, Not
+};
+
+const std::string& symbolKindName(SymbolKind kind); // None 为空串
+const std::string& opSpelling(BinaryOp op);
+const std::string& opSpelling(UnaryOp op);
+
+inline bool isComparison(BinaryOp op) { return op >= BinaryOp::Eq && op <= BinaryOp::Ge; }
+inline bool isLogical(BinaryOp op) { return op == BinaryOp::LogicalAnd || op == BinaryOp::LogicalOr; }
+
+inline std::ostream& operator<<(std::ostream& out, SymbolKind kind) { return out << symbolKindName(kind); }
+inline std::ostream& operator<<(std::ostream& out, BinaryOp op) { return out << opSpelling(op); }
+inline std::ostream& operator<<(std::ostream& out, UnaryOp op) { return out << opSpelling(op); }
+
+// 节点上记录的语义错误种类（完整的错误信息保存在语义分析器中）
+enum class NodeError : unsigned char {
+    None, UndeclaredIdentifier, InvalidBinaryOperation
+};
+
+const std::string& nodeErrorMessage(NodeError error);
+
+// 语义信息结构：每个节点都带一份，只保留定长的小字段（共8字节）
 struct SemanticInfo {
-    std::string type;           // 类型信息
+    TypeId type;                // 类型信息
+    uint16_t scopeLevel;        // 作用域层级
+    SymbolKind symbolKind;      // 符号种类：variable, function, parameter
+    NodeError error;            // 语义错误种类
     bool isInitialized;         // 是否已初始化
-    int scopeLevel;             // 作用域层级
-    std::string symbolKind;     // 符号种类：variable, function, parameter
-    bool hasSemanticError;      // 是否有语义错误
-    std::string errorMessage;   // 错误信息
     
-    SemanticInfo() : isInitialized(false), scopeLevel(0), hasSemanticError(false) {}
+    SemanticInfo()
+        : type(TypeKind::None), scopeLevel(0), symbolKind(SymbolKind::None),
+          error(NodeError::None), isInitialized(false) {}
+
+    bool hasSemanticError() const { return error != NodeError::None; }
+};
+
+// 名字解析结果：语义分析时填写，之后的阶段按编号直接定位符号，不再按名字查找
+struct Binding {
+    int symbol;     // 符号在整个程序中的声明序号，-1表示未解析
+    int slot;       // 参数和局部变量在所属函数栈帧中的槽位，全局变量和函数为-1
+
+    Binding() : symbol(-1), slot(-1) {}
 };
 
 // AST节点基类
+// 节点由AstArena分配并随其整体释放，子节点指针不持有所有权，
+// 因此不再通过基类指针delete，析构函数也不必是虚函数
 class ASTNode {
 public:
     SemanticInfo semanticInfo;  // 语义信息
     int lineNumber;             // 行号信息
     
     ASTNode() : lineNumber(0) {}
-    virtual ~ASTNode() = default;
     virtual void accept(Visitor* visitor) = 0;
     virtual void print(int indent = 0) const = 0;
     virtual void printWithSemantics(int indent = 0) const = 0;  // 打印带语义信息的树
+
+protected:
+    ~ASTNode() = default;
 };
 
 // 表达式基类
 class Expression : public ASTNode {
-public:
-    virtual ~Expression() = default;
+protected:
+    ~Expression() = default;
 };
 
 // 语句基类
 class Statement : public ASTNode {
-public:
-    virtual ~Statement() = default;
+protected:
+    ~Statement() = default;
 };
 
 // 整数字面量
@@ -60,9 +112,10 @@ public:
 // 标识符
 class Identifier : public Expression {
 public:
-    std::string name;
+    Name name;
+    Binding binding;    // 所引用的符号
     
-    Identifier(const std::string& n) : name(n) {}
+    Identifier(Name n) : name(n) {}
     void accept(Visitor* visitor) override;
     void print(int indent = 0) const override;
     void printWithSemantics(int indent = 0) const override;
@@ -71,12 +124,12 @@ public:
 // 二元运算表达式
 class BinaryExpression : public Expression {
 public:
-    std::unique_ptr<Expression> left;
-    std::string op;
-    std::unique_ptr<Expression> right;
+    Expression* left;
+    BinaryOp op;
+    Expression* right;
     
-    BinaryExpression(std::unique_ptr<Expression> l, const std::string& o, std::unique_ptr<Expression> r)
-        : left(std::move(l)), op(o), right(std::move(r)) {}
+    BinaryExpression(Expression* l, BinaryOp o, Expression* r)
+        : left(l), op(o), right(r) {}
     
     void accept(Visitor* visitor) override;
     void print(int indent = 0) const override;
@@ -86,11 +139,11 @@ public:
 // 一元运算表达式
 class UnaryExpression : public Expression {
 public:
-    std::string op;
-    std::unique_ptr<Expression> operand;
+    UnaryOp op;
+    Expression* operand;
     
-    UnaryExpression(const std::string& o, std::unique_ptr<Expression> expr)
-        : op(o), operand(std::move(expr)) {}
+    UnaryExpression(UnaryOp o, Expression* expr)
+        : op(o), operand(expr) {}
     
     void accept(Visitor* visitor) override;
     void print(int indent = 0) const override;
@@ -100,11 +153,11 @@ public:
 // 赋值表达式
 class AssignmentExpression : public Expression {
 public:
-    std::unique_ptr<Identifier> left;
-    std::unique_ptr<Expression> right;
+    Identifier* left;       // 被赋值的变量，其binding即赋值目标
+    Expression* right;
     
-    AssignmentExpression(std::unique_ptr<Identifier> l, std::unique_ptr<Expression> r)
-        : left(std::move(l)), right(std::move(r)) {}
+    AssignmentExpression(Identifier* l, Expression* r)
+        : left(l), right(r) {}
     
     void accept(Visitor* visitor) override;
     void print(int indent = 0) const override;
@@ -114,10 +167,11 @@ public:
 // 函数调用表达式
 class FunctionCall : public Expression {
 public:
-    std::string name;
-    std::vector<std::unique_ptr<Expression>> arguments;
+    Name name;
+    std::vector<Expression*> arguments;
+    Binding binding;    // 被调函数
     
-    FunctionCall(const std::string& n) : name(n) {}
+    FunctionCall(Name n) : name(n) {}
     void accept(Visitor* visitor) override;
     void print(int indent = 0) const override;
     void printWithSemantics(int indent = 0) const override;
@@ -126,9 +180,9 @@ public:
 // 表达式语句
 class ExpressionStatement : public Statement {
 public:
-    std::unique_ptr<Expression> expression;
+    Expression* expression;
     
-    ExpressionStatement(std::unique_ptr<Expression> expr) : expression(std::move(expr)) {}
+    ExpressionStatement(Expression* expr) : expression(expr) {}
     void accept(Visitor* visitor) override;
     void print(int indent = 0) const override;
     void printWithSemantics(int indent = 0) const override;
@@ -137,11 +191,12 @@ public:
 // 变量声明
 class VariableDeclaration : public Statement {
 public:
-    std::string type;
-    std::vector<std::string> names;
-    std::vector<std::pair<std::string, std::unique_ptr<Expression>>> initDeclarators;
+    TypeId type;
+    std::vector<Name> names;
+    std::vector<std::pair<Name, Expression*>> initDeclarators;
+    int firstSlot;  // 栈帧槽位：names依次占用firstSlot起的槽位，initDeclarators紧随其后；全局声明为-1
     
-    VariableDeclaration(const std::string& t) : type(t) {}
+    VariableDeclaration(TypeId t) : type(t), firstSlot(-1) {}
     void accept(Visitor* visitor) override;
     void print(int indent = 0) const override;
     void printWithSemantics(int indent = 0) const override;
@@ -150,7 +205,7 @@ public:
 // 复合语句（代码块）
 class CompoundStatement : public Statement {
 public:
-    std::vector<std::unique_ptr<Statement>> statements;
+    std::vector<Statement*> statements;
     
     void accept(Visitor* visitor) override;
     void print(int indent = 0) const override;
@@ -160,12 +215,12 @@ public:
 // If语句
 class IfStatement : public Statement {
 public:
-    std::unique_ptr<Expression> condition;
-    std::unique_ptr<Statement> thenStmt;
-    std::unique_ptr<Statement> elseStmt; // 可选
+    Expression* condition;
+    Statement* thenStmt;
+    Statement* elseStmt; // 可选
     
-    IfStatement(std::unique_ptr<Expression> cond, std::unique_ptr<Statement> then_stmt)
-        : condition(std::move(cond)), thenStmt(std::move(then_stmt)), elseStmt(nullptr) {}
+    IfStatement(Expression* cond, Statement* then_stmt)
+        : condition(cond), thenStmt(then_stmt), elseStmt(nullptr) {}
     
     void accept(Visitor* visitor) override;
     void print(int indent = 0) const override;
@@ -175,11 +230,11 @@ public:
 // While语句
 class WhileStatement : public Statement {
 public:
-    std::unique_ptr<Expression> condition;
-    std::unique_ptr<Statement> body;
+    Expression* condition;
+    Statement* body;
     
-    WhileStatement(std::unique_ptr<Expression> cond, std::unique_ptr<Statement> b)
-        : condition(std::move(cond)), body(std::move(b)) {}
+    WhileStatement(Expression* cond, Statement* b)
+        : condition(cond), body(b) {}
     
     void accept(Visitor* visitor) override;
     void print(int indent = 0) const override;
@@ -189,14 +244,14 @@ public:
 // For语句
 class ForStatement : public Statement {
 public:
-    std::unique_ptr<Statement> init;      // 初始化语句
-    std::unique_ptr<Expression> condition; // 条件表达式
-    std::unique_ptr<Expression> update;    // 更新表达式
-    std::unique_ptr<Statement> body;       // 循环体
+    Statement* init;      // 初始化语句
+    Expression* condition; // 条件表达式
+    Expression* update;    // 更新表达式
+    Statement* body;       // 循环体
     
-    ForStatement(std::unique_ptr<Statement> i, std::unique_ptr<Expression> c, 
-                std::unique_ptr<Expression> u, std::unique_ptr<Statement> b)
-        : init(std::move(i)), condition(std::move(c)), update(std::move(u)), body(std::move(b)) {}
+    ForStatement(Statement* i, Expression* c, 
+                Expression* u, Statement* b)
+        : init(i), condition(c), update(u), body(b) {}
     
     void accept(Visitor* visitor) override;
     void print(int indent = 0) const override;
@@ -206,9 +261,9 @@ public:
 // Return语句
 class ReturnStatement : public Statement {
 public:
-    std::unique_ptr<Expression> value; 
+    Expression* value; 
     
-    ReturnStatement(std::unique_ptr<Expression> val = nullptr) : value(std::move(val)) {}
+    ReturnStatement(Expression* val = nullptr) : value(val) {}
     void accept(Visitor* visitor) override;
     void print(int indent = 0) const override;
     void printWithSemantics(int indent = 0) const override;
@@ -217,13 +272,14 @@ public:
 // 函数定义
 class FunctionDefinition : public ASTNode {
 public:
-    std::string returnType;
-    std::string name;
-    std::vector<std::pair<std::string, std::string>> parameters; // (type, name)
-    std::unique_ptr<CompoundStatement> body;
+    TypeId returnType;
+    Name name;
+    std::vector<std::pair<TypeId, Name>> parameters; // (type, name)
+    CompoundStatement* body;
+    int frameSize;  // 栈帧槽位数（参数占前parameters.size()个）
     
-    FunctionDefinition(const std::string& ret_type, const std::string& n)
-        : returnType(ret_type), name(n) {}
+    FunctionDefinition(TypeId ret_type, Name n)
+        : returnType(ret_type), name(n), body(nullptr), frameSize(0) {}
     
     void accept(Visitor* visitor) override;
     void print(int indent = 0) const override;
@@ -233,8 +289,10 @@ public:
 // 程序根节点
 class Program : public ASTNode {
 public:
-    std::vector<std::unique_ptr<ASTNode>> declarations; // 函数定义和全局变量声明
+    std::vector<ASTNode*> declarations; // 函数定义和全局变量声明
+    AstArena* arena;                    // 整棵树所在的内存池（后续阶段新建节点也分配在其中）
     
+    explicit Program(AstArena* a) : arena(a) {}
     void accept(Visitor* visitor) override;
     void print(int indent = 0) const override;
     void printWithSemantics(int indent = 0) const override;
@@ -0,0 +1,297 @@
+#include "cache.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include <thread>
+
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+
+const char kEntryMagic[] = "C-COMPILER-CACHE 1\n";
+
+inline uint64_t rotl(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+inline uint64_t fmix(uint64_t k) {
+    k ^= k >> 33;
+    k *= 0xff51afd7ed558ccdULL;
+    k ^= k >> 33;
+    k *= 0xc4ceb9fe1a85ec53ULL;
+    k ^= k >> 33;
+    return k;
+}
+
+inline uint64_t load64(const unsigned char* p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+// MurmurHash3 x64_128，两路64位状态以seed初始化
+CacheKey murmur128(const void* data, size_t size, uint64_t seed1, uint64_t seed2) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    const uint64_t c1 = 0x87c37b91114253d5ULL;
+    const uint64_t c2 = 0x4cf5ad432745937fULL;
+    uint64_t h1 = seed1;
+    uint64_t h2 = seed2;
+
+    size_t blocks = size / 16;
+    for (size_t i = 0; i < blocks; i++) {
+        uint64_t k1 = load64(bytes + i * 16);
+        uint64_t k2 = load64(bytes + i * 16 + 8);
+        k1 *= c1; k1 = rotl(k1, 31); k1 *= c2; h1 ^= k1;
+        h1 = rotl(h1, 27); h1 += h2; h1 = h1 * 5 + 0x52dce729;
+        k2 *= c2; k2 = rotl(k2, 33); k2 *= c1; h2 ^= k2;
+        h2 = rotl(h2, 31); h2 += h1; h2 = h2 * 5 + 0x38495ab5;
+    }
+
+    const unsigned char* tail = bytes + blocks * 16;
+    uint64_t k1 = 0;
+    uint64_t k2 = 0;
+    size_t rest = size & 15;
+    for (size_t i = rest; i > 8; i--) {
+        k2 ^= static_cast<uint64_t>(tail[i - 1]) << ((i - 9) * 8);
+    }
+    if (rest > 8) {
+        k2 *= c2; k2 = rotl(k2, 33); k2 *= c1; h2 ^= k2;
+    }
+    for (size_t i = std::min<size_t>(rest, 8); i > 0; i--) {
+        k1 ^= static_cast<uint64_t>(tail[i - 1]) << ((i - 1) * 8);
+    }
+    if (rest > 0) {
+        k1 *= c1; k1 = rotl(k1, 31); k1 *= c2; h1 ^= k1;
+    }
+
+    h1 ^= size;
+    h2 ^= size;
+    h1 += h2;
+    h2 += h1;
+    h1 = fmix(h1);
+    h2 = fmix(h2);
+    h1 += h2;
+    h2 += h1;
+    return CacheKey{h1, h2};
+}
+
+// 编译器自身的标识：版本号加上可执行文件的大小和修改时间，
+// 重新构建编译器后旧的缓存条目自然失效
+const std::string& compilerIdentity() {
+    static const std::string identity = []() {
+        std::string text = "v1.0 ";
+        std::error_code error;
+        fs::path exe = fs::read_symlink("/proc/self/exe", error);
+        uintmax_t size = error ? 0 : fs::file_size(exe, error);
+        if (!error) {
+            auto time = fs::last_write_time(exe, error);
+            text += std::to_string(size) + " " + std::to_string(time.time_since_epoch().count());
+        }
+        if (error) {
+            text += __DATE__ " " __TIME__;
+        }
+        return text;
+    }();
+    return identity;
+}
+
+// 解析条目文件，逐段回调 (名称, 内容)；格式不符时返回false
+bool parseEntry(const std::string& entry, const std::function<void(const std::string&, std::string)>& visit) {
+    size_t magicLength = sizeof(kEntryMagic) - 1;
+    if (entry.compare(0, magicLength, kEntryMagic) != 0) {
+        return false;
+    }
+    size_t pos = magicLength;
+    while (pos < entry.size()) {
+        size_t lineEnd = entry.find('\n', pos);
+        if (lineEnd == std::string::npos) {
+            return false;
+        }
+        std::istringstream header(entry.substr(pos, lineEnd - pos));
+        std::string name;
+        size_t length;
+        if (!(header >> name >> length) || length > entry.size() - lineEnd - 1) {
+            return false;
+        }
+        visit(name, entry.substr(lineEnd + 1, length));
+        pos = lineEnd + 1 + length;
+    }
+    return true;
+}
+
+// 条目文件名为32位十六进制的键；目录中的其他文件（包括写入中的临时文件）不属于缓存
+bool isEntryName(const std::string& name) {
+    return name.size() == 32 && std::all_of(name.begin(), name.end(), [](char c) {
+        return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f');
+    });
+}
+
+int processId() {
+#ifdef _WIN32
+    return _getpid();
+#else
+    return static_cast<int>(getpid());
+#endif
+}
+
+bool readFile(const std::string& path, std::string& content) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    std::ostringstream buffer;
+    buffer << file.rdbuf();
+    content = buffer.str();
+    return true;
+}
+
+} // namespace
+
+std::string CacheKey::hex() const {
+    char text[33];
+    snprintf(text, sizeof(text), "%016llx%016llx",
+             static_cast<unsigned long long>(high), static_cast<unsigned long long>(low));
+    return text;
+}
+
+CompileCache::CompileCache(const std::string& directory, uint64_t maxBytes)
+    : directory(directory), maxBytes(maxBytes), scanned(false), estimatedBytes(0) {
+}
+
+bool CompileCache::prepare() {
+    std::error_code error;
+    fs::create_directories(directory, error);
+    return fs::is_directory(directory, error);
+}
+
+std::string CompileCache::entryPath(const CacheKey& key) const {
+    return (fs::path(directory) / key.hex()).string();
+}
+
+CacheKey CompileCache::key(const char* source, size_t size, const std::string& options) {
+    std::string header = compilerIdentity() + '\0' + options;
+    CacheKey seed = murmur128(header.data(), header.size(), 0, 0);
+    return murmur128(source, size, seed.high, seed.low);
+}
+
+bool CompileCache::lookup(const CacheKey& key, const std::string& section, std::string& data) {
+    std::vector<std::pair<std::string, std::string>> sections = {{section, std::string()}};
+    if (!lookup(key, sections)) {
+        return false;
+    }
+    data = std::move(sections[0].second);
+    return true;
+}
+
+bool CompileCache::lookup(const CacheKey& key, std::vector<std::pair<std::string, std::string>>& sections) {
+    std::string path = entryPath(key);
+    std::string entry;
+    if (!readFile(path, entry)) {
+        return false;
+    }
+    size_t found = 0;
+    bool valid = parseEntry(entry, [&](const std::string& name, std::string content) {
+        for (auto& section : sections) {
+            if (section.first == name) {
+                section.second = std::move(content);
+                found++;
+                break;
+            }
+        }
+    });
+    if (!valid || found != sections.size()) {
+        return false;
+    }
+    // 刷新修改时间，作为LRU淘汰的依据
+    std::error_code error;
+    fs::last_write_time(path, fs::file_time_type::clock::now(), error);
+    return true;
+}
+
+void CompileCache::store(const CacheKey& key, const std::vector<std::pair<std::string, std::string>>& sections) {
+    std::string path = entryPath(key);
+    std::string entry = kEntryMagic;
+    for (const auto& section : sections) {
+        entry += section.first + " " + std::to_string(section.second.size()) + "\n";
+        entry += section.second;
+    }
+
+    // 临时文件名区分进程、线程和时刻，写完后改名替换，读者只会看到完整的条目
+    std::string temporary = path + ".tmp" + std::to_string(processId()) + "_" +
+        std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + "_" +
+        std::to_string(std::chrono::steady_clock::now().time_since_epoch().count());
+    {
+        std::ofstream file(temporary, std::ios::binary);
+        if (!file.write(entry.data(), entry.size())) {
+            file.close();
+            std::remove(temporary.c_str());
+            return;
+        }
+    }
+    std::error_code error;
+    fs::rename(temporary, path, error);
+    if (error) {
+        std::remove(temporary.c_str());
+        return;
+    }
+    evict(entry.size());
+}
+
+void CompileCache::evict(uint64_t written) {
+    std::lock_guard<std::mutex> lock(evictMutex);
+    // 覆盖已有条目时估计值偏大，至多导致提前扫描一次
+    if (scanned) {
+        estimatedBytes += written;
+        if (estimatedBytes <= maxBytes) {
+            return;
+        }
+    }
+    struct Entry {
+        fs::path path;
+        uintmax_t size;
+        fs::file_time_type time;
+    };
+    std::vector<Entry> entries;
+    uintmax_t total = 0;
+    std::error_code error;
+    for (fs::directory_iterator it(directory, error), end; !error && it != end; it.increment(error)) {
+        std::error_code entryError;
+        if (!isEntryName(it->path().filename().string()) || !it->is_regular_file(entryError)) {
+            continue;
+        }
+        Entry entry{it->path(), it->file_size(entryError), it->last_write_time(entryError)};
+        if (!entryError) {
+            total += entry.size;
+            entries.push_back(std::move(entry));
+        }
+    }
+    scanned = true;
+    estimatedBytes = total;
+    if (total <= maxBytes) {
+        return;
+    }
+    // 淘汰到上限的九成以下，避免之后每次写入都触发淘汰
+    std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.time < b.time; });
+    uintmax_t target = maxBytes / 10 * 9;
+    for (const Entry& entry : entries) {
+        if (total <= target) {
+            break;
+        }
+        std::error_code removeError;
+        if (fs::remove(entry.path, removeError)) {
+            total -= entry.size;
+        }
+    }
+    estimatedBytes = total;
+}
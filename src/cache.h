@@ -0,0 +1,58 @@
+#ifndef CACHE_H
+#define CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+// 缓存键：源文件内容、编译器版本和影响输出的选项共同决定的128位哈希
+struct CacheKey {
+    uint64_t high;
+    uint64_t low;
+
+    std::string hex() const;
+};
+
+// 磁盘编译缓存：以内容哈希为键，每个键对应目录中的一个条目文件，
+// 文件内按名称保存多段结果（最终汇编、优化后的IR、窥孔统计等）。
+// 写入先写临时文件再改名，多个进程/线程同时使用同一目录也不会读到残缺条目。
+// 目录总大小超过上限时按最近使用时间（命中时刷新文件修改时间）淘汰最旧的条目；
+// 只统计和删除条目文件，目录中的其他文件不受影响。
+// 目录大小在内存中估计，只在首次写入和估计值超过上限时扫描目录，
+// 因此一次编译写入大量条目（如按函数缓存）时不会反复扫描
+class CompileCache {
+private:
+    std::string directory;
+    uint64_t maxBytes;
+    std::mutex evictMutex;      // 同一进程内只有一个线程执行淘汰
+    bool scanned;               // 是否已扫描过目录（以下两项由evictMutex保护）
+    uint64_t estimatedBytes;    // 目录大小的估计：上次扫描的结果加上此后本进程写入的条目
+
+    std::string entryPath(const CacheKey& key) const;
+    void evict(uint64_t written);
+
+public:
+    CompileCache(const std::string& directory, uint64_t maxBytes);
+    CompileCache(const CompileCache&) = delete;
+    CompileCache& operator=(const CompileCache&) = delete;
+
+    // 创建缓存目录，失败时返回false
+    bool prepare();
+
+    // 计算源文件的缓存键；options列出影响输出的编译选项
+    static CacheKey key(const char* source, size_t size, const std::string& options);
+
+    // 读取条目中名为section的一段，命中时同时刷新条目的使用时间
+    bool lookup(const CacheKey& key, const std::string& section, std::string& data);
+
+    // 一次读取多段：sections给出各段名称，命中时填写内容；全部找到才返回true
+    bool lookup(const CacheKey& key, std::vector<std::pair<std::string, std::string>>& sections);
+
+    // 写入完整的条目，整体替换该键已有的条目（不与已有内容合并，并发写入时以最后完成者为准）
+    void store(const CacheKey& key, const std::vector<std::pair<std::string, std::string>>& sections);
+};
+
+#endif // CACHE_H
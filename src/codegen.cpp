@@ -1,344 +1,560 @@
 #include "codegen.h"
+#include "cache.h"
+#include "fingerprint.h"
+#include "optimizer.h"
+#include "parallel.h"
 #include <iostream>
-#include <sstream>
 
-CodeGenerator::CodeGenerator(std::ostream& out) 
-    : output(out), stackOffset(0), labelCounter(0) {
+// System V x86-64 整数参数寄存器
+static const int kArgumentRegisters[] = {RDI, RSI, RDX, RCX, R8, R9};
+static const int kArgumentRegisterCount = 6;
+
+FunctionGenerator::FunctionGenerator(bool optimize)
+    : function(nullptr), allocation(nullptr), optimize(optimize) {
+}
+
+void FunctionGenerator::emit(const std::string& opcode, const std::string& src, const std::string& dst) {
+    code.emplace_back(AsmKind::Instruction, opcode, src, dst);
+}
+
+std::string FunctionGenerator::blockLabel(int block) const {
+    // 标签按函数划分命名空间，.L前缀的局部标签不进入符号表
+    return ".L" + function->name + "_" + function->blocks[block].name + std::to_string(block);
+}
+
+std::string FunctionGenerator::operand(int vreg) const {
+    const VRegLocation& loc = allocation->location(vreg);
+    if (loc.isConstant) {
+        return "$" + std::to_string(loc.value);
+    }
+    if (loc.reg >= 0) {
+        return regName64(loc.reg);
+    }
+    return "-" + std::to_string(loc.slot) + "(%rbp)";
 }
 
-std::string CodeGenerator::generateLabel(const std::string& prefix) {
-    return prefix + std::to_string(labelCounter++);
+void FunctionGenerator::generateFunctionPrologue(std::ostream& target) {
+    target << ".section .text\n";
+    target << ".globl " << function->name << '\n';
+    target << function->name << ":\n";
+    target << "    pushq %rbp\n";
+    target << "    movq %rsp, %rbp\n";
+    // 为溢出值和寄存器保存区预留栈空间
+    int size = frame.frameSize();
+    if (size > 0) {
+        target << "    subq $" << size << ", %rsp\n";
+    }
+    const auto& saved = allocation->usedCalleeSavedRegisters();
+    for (size_t i = 0; i < saved.size(); i++) {
+        target << "    movq " << regName64(saved[i]) << ", -" << calleeSavedSlots[i] << "(%rbp)\n";
+    }
 }
 
-void CodeGenerator::allocateVariable(const std::string& name) {
-    stackOffset += 8; // 64位环境下使用8字节对齐
-    symbolTable[name] = stackOffset;
+void FunctionGenerator::generateFunctionEpilogue() {
+    const auto& saved = allocation->usedCalleeSavedRegisters();
+    for (size_t i = 0; i < saved.size(); i++) {
+        emit("movq", "-" + std::to_string(calleeSavedSlots[i]) + "(%rbp)", regName64(saved[i]));
+    }
+    emit("leave");
+    emit("ret");
 }
 
-std::string CodeGenerator::getVariableAddress(const std::string& name) {
-    if (symbolTable.find(name) == symbolTable.end()) {
-        std::cerr << "Error: Undefined variable '" << name << "'" << std::endl;
-        return "";
+void FunctionGenerator::emitMove(const std::string& source, int dst) {
+    std::string target = operand(dst);
+    if (source == target) {
+        return;
+    }
+    if (!inRegister(dst) && source.back() == ')') {
+        emit("movq", source, "%rax");
+        emit("movq", "%rax", target);
+    } else {
+        emit("movq", source, target);
+    }
+}
+
+void FunctionGenerator::emitParallelMoves(std::vector<std::pair<std::string, int>> moves) {
+    // moves: (源操作数, 目标物理寄存器)
+    for (size_t i = 0; i < moves.size();) {
+        if (moves[i].first == regName64(moves[i].second)) {
+            moves.erase(moves.begin() + i);
+        } else {
+            i++;
+        }
+    }
+
+    while (!moves.empty()) {
+        bool progress = false;
+        for (size_t i = 0; i < moves.size(); i++) {
+            std::string dst = regName64(moves[i].second);
+            bool blocked = false;
+            for (size_t j = 0; j < moves.size(); j++) {
+                if (j != i && moves[j].first == dst) {
+                    blocked = true;
+                    break;
+                }
+            }
+            if (!blocked) {
+                emit("movq", moves[i].first, dst);
+                moves.erase(moves.begin() + i);
+                progress = true;
+                break;
+            }
+        }
+        if (!progress) {
+            // 全部处于环中：把一个目标寄存器的旧值暂存到%rax
+            std::string dst = regName64(moves[0].second);
+            emit("movq", dst, "%rax");
+            for (auto& move : moves) {
+                if (move.first == dst) {
+                    move.first = "%rax";
+                }
+            }
+        }
     }
-    return "-" + std::to_string(symbolTable[name]) + "(%rbp)";
 }
 
-void CodeGenerator::generateFunctionPrologue(const std::string& funcName) {
-    output << ".section .text" << std::endl;
-    output << ".globl " << funcName << std::endl;
-    output << funcName << ":" << std::endl;
-    output << "    pushq %rbp" << std::endl;
-    output << "    movq %rsp, %rbp" << std::endl;
-    // 为局部变量预留栈空间
-    if (stackOffset > 0) {
-        output << "    subq $" << stackOffset << ", %rsp" << std::endl;
+void FunctionGenerator::generateParams(int count) {
+    // 调用者只保证低32位有效，先在参数寄存器中按int符号扩展
+    std::vector<std::pair<std::string, int>> moves;
+    std::vector<std::pair<int, int>> stackParams;  // (虚拟寄存器, 参数序号)
+    std::vector<std::pair<int, int>> memoryParams; // 目标在栈槽中的寄存器参数
+    const auto& entry = function->blocks[0].instrs;
+    for (int i = 0; i < count; i++) {
+        int vreg = entry[i].dst;
+        int index = entry[i].imm;
+        if (index >= kArgumentRegisterCount) {
+            stackParams.emplace_back(vreg, index);
+            continue;
+        }
+        int argReg = kArgumentRegisters[index];
+        emit("movslq", regName32(argReg), regName64(argReg));
+        if (inRegister(vreg)) {
+            moves.emplace_back(regName64(argReg), allocation->location(vreg).reg);
+        } else {
+            memoryParams.emplace_back(vreg, argReg);
+        }
+    }
+
+    // 栈槽目标不会与任何源冲突，先写出
+    for (const auto& param : memoryParams) {
+        emit("movq", regName64(param.second), operand(param.first));
+    }
+    emitParallelMoves(moves);
+
+    // 第7个及以后的参数位于调用者栈帧 16(%rbp) 起
+    for (const auto& param : stackParams) {
+        std::string address = std::to_string(16 + (param.second - kArgumentRegisterCount) * 8) + "(%rbp)";
+        if (inRegister(param.first)) {
+            emit("movslq", address, operand(param.first));
+        } else {
+            emit("movslq", address, "%rax");
+            emit("movq", "%rax", operand(param.first));
+        }
     }
 }
 
-void CodeGenerator::generateFunctionEpilogue() {
-    output << "    leave" << std::endl;
-    output << "    ret" << std::endl;
+void FunctionGenerator::generateCall(const IRInstr& instr) {
+    int argCount = instr.b;
+    auto arg = [&](int i) { return function->callArgs[instr.a + i]; };
+
+    // 第7个及以后的参数从右向左压栈，调用点保持%rsp 16字节对齐
+    int stackArgs = argCount > kArgumentRegisterCount ? argCount - kArgumentRegisterCount : 0;
+    int padding = (stackArgs % 2) * 8;
+    if (padding > 0) {
+        emit("subq", "$" + std::to_string(padding), "%rsp");
+    }
+    for (int i = argCount - 1; i >= kArgumentRegisterCount; i--) {
+        emit("pushq", operand(arg(i)));
+    }
+
+    // 前6个参数装入参数寄存器
+    std::vector<std::pair<std::string, int>> moves;
+    for (int i = 0; i < argCount && i < kArgumentRegisterCount; i++) {
+        moves.emplace_back(operand(arg(i)), kArgumentRegisters[i]);
+    }
+    emitParallelMoves(moves);
+
+    // 调用函数，返回值按int符号扩展
+    emit("call", function->callees[instr.imm]);
+    emit("cltq");
+
+    // 清理栈参数
+    if (stackArgs > 0) {
+        emit("addq", "$" + std::to_string(stackArgs * 8 + padding), "%rsp");
+    }
+    emitMove("%rax", instr.dst);
 }
 
-void CodeGenerator::visit(IntegerLiteral* node) {
-    output << "    movq $" << node->value << ", %rax" << std::endl;
+bool FunctionGenerator::fusesWithBranch(int block, size_t index) const {
+    const auto& instrs = function->blocks[block].instrs;
+    const IRInstr& instr = instrs[index];
+    return instr.isCompare() && index + 1 < instrs.size() &&
+           instrs[index + 1].op == IROp::Branch && instrs[index + 1].a == instr.dst &&
+           useCounts[instr.dst] == 1;
 }
 
-void CodeGenerator::visit(Identifier* node) {
-    std::string address = getVariableAddress(node->name);
-    if (!address.empty()) {
-        output << "    movq " << address << ", %rax" << std::endl;
+static const char* conditionCode(IROp op) {
+    switch (op) {
+        case IROp::CmpEq: return "e";
+        case IROp::CmpNe: return "ne";
+        case IROp::CmpLt: return "l";
+        case IROp::CmpGt: return "g";
+        case IROp::CmpLe: return "le";
+        default: return "ge";
     }
 }
 
-void CodeGenerator::visit(BinaryExpression* node) {
-    // 先计算右操作数并保存到临时内存位置
-    node->right->accept(this);
-    // 分配8字节的临时空间
-    stackOffset += 8;
-    int rightTempOffset = stackOffset; // 记住右操作数的位置
-    output << "    movq %rax, -" << rightTempOffset << "(%rbp)" << std::endl;
-    
-    // 再计算左操作数
-    node->left->accept(this);
-    // 从临时内存位置加载右操作数
-    output << "    movq -" << rightTempOffset << "(%rbp), %rbx" << std::endl;
-    
-    // 执行运算
-    if (node->op == "+") {
-        output << "    addq %rbx, %rax" << std::endl;
-    } else if (node->op == "-") {
-        output << "    subq %rbx, %rax" << std::endl;
-    } else if (node->op == "*") {
-        output << "    imulq %rbx, %rax" << std::endl;
-    } else if (node->op == "/") {
-        output << "    cqto" << std::endl;
-        output << "    idivq %rbx" << std::endl;
-    } else if (node->op == "%") {
-        output << "    cqto" << std::endl;
-        output << "    idivq %rbx" << std::endl;
-        output << "    movq %rdx, %rax" << std::endl;
-    } else if (node->op == "==") {
-        output << "    cmpq %rbx, %rax" << std::endl;
-        output << "    sete %al" << std::endl;
-        output << "    movzbq %al, %rax" << std::endl;
-    } else if (node->op == "!=") {
-        output << "    cmpq %rbx, %rax" << std::endl;
-        output << "    setne %al" << std::endl;
-        output << "    movzbq %al, %rax" << std::endl;
-    } else if (node->op == "<") {
-        output << "    cmpq %rbx, %rax" << std::endl;
-        output << "    setl %al" << std::endl;
-        output << "    movzbq %al, %rax" << std::endl;
-    } else if (node->op == ">") {
-        output << "    cmpq %rbx, %rax" << std::endl;
-        output << "    setg %al" << std::endl;
-        output << "    movzbq %al, %rax" << std::endl;
-    } else if (node->op == "<=") {
-        output << "    cmpq %rbx, %rax" << std::endl;
-        output << "    setle %al" << std::endl;
-        output << "    movzbq %al, %rax" << std::endl;
-    } else if (node->op == ">=") {
-        output << "    cmpq %rbx, %rax" << std::endl;
-        output << "    setge %al" << std::endl;
-        output << "    movzbq %al, %rax" << std::endl;
-    } else if (node->op == "&&") {
-        output << "    testq %rax, %rax" << std::endl;
-        output << "    setne %al" << std::endl;
-        output << "    testq %rbx, %rbx" << std::endl;
-        output << "    setne %bl" << std::endl;
-        output << "    andb %bl, %al" << std::endl;
-        output << "    movzbq %al, %rax" << std::endl;
-    } else if (node->op == "||") {
-        output << "    orq %rbx, %rax" << std::endl;
-        output << "    testq %rax, %rax" << std::endl;
-        output << "    setne %al" << std::endl;
-        output << "    movzbq %al, %rax" << std::endl;
+// 交换比较操作数后的等价比较
+static IROp swapCompare(IROp op) {
+    switch (op) {
+        case IROp::CmpLt: return IROp::CmpGt;
+        case IROp::CmpGt: return IROp::CmpLt;
+        case IROp::CmpLe: return IROp::CmpGe;
+        case IROp::CmpGe: return IROp::CmpLe;
+        default: return op;
     }
 }
 
-void CodeGenerator::visit(UnaryExpression* node) {
-    node->operand->accept(this);
-    
-    if (node->op == "-") {
-        output << "    negq %rax" << std::endl;
-    } else if (node->op == "!") {
-        output << "    testq %rax, %rax" << std::endl;
-        output << "    sete %al" << std::endl;
-        output << "    movzbq %al, %rax" << std::endl;
+// 条件取反后的比较
+static IROp negateCompare(IROp op) {
+    switch (op) {
+        case IROp::CmpEq: return IROp::CmpNe;
+        case IROp::CmpNe: return IROp::CmpEq;
+        case IROp::CmpLt: return IROp::CmpGe;
+        case IROp::CmpGt: return IROp::CmpLe;
+        case IROp::CmpLe: return IROp::CmpGt;
+        default: return IROp::CmpLt;
     }
 }
 
-void CodeGenerator::visit(AssignmentExpression* node) {
-    // 计算右操作数
-    node->right->accept(this);
-    
-    // 存储到左操作数（变量）
-    std::string address = getVariableAddress(node->left->name);
-    if (!address.empty()) {
-        output << "    movq %rax, " << address << std::endl;
+IROp FunctionGenerator::emitCompare(const IRInstr& instr) {
+    // cmpq 的第二个操作数不能是立即数：左侧为常量时交换两侧
+    IROp op = instr.op;
+    int left = instr.a;
+    int right = instr.b;
+    if (isConstant(left) && !isConstant(right)) {
+        std::swap(left, right);
+        op = swapCompare(op);
+    }
+    std::string a = operand(left);
+    if (!inRegister(left) && (isConstant(left) || !inRegister(right))) {
+        emit("movq", a, "%rax");
+        a = "%rax";
     }
+    emit("cmpq", operand(right), a);
+    return op;
 }
 
-void CodeGenerator::visit(FunctionCall* node) {
-    // 简单的函数调用处理
-    if (node->name == "printf") {
-        // 处理printf函数调用
-        output << "    # printf function call" << std::endl;
-    } else {
-        // 处理参数
-        for (int i = node->arguments.size() - 1; i >= 0; i--) {
-            node->arguments[i]->accept(this);
-            output << "    push %rax" << std::endl;
+void FunctionGenerator::generateBinary(const IRInstr& instr) {
+    std::string a = operand(instr.a);
+    std::string b = operand(instr.b);
+    std::string d = operand(instr.dst);
+
+    if (instr.op == IROp::Div || instr.op == IROp::Mod) {
+        // idivq 固定使用 %rdx:%rax，除数不能是立即数
+        emit("movq", a, "%rax");
+        emit("cqto");
+        if (isConstant(instr.b)) {
+            emit("movq", b, "%r11");
+            b = "%r11";
         }
-        
-        // 调用函数
-        output << "    call " << node->name << std::endl;
-        
-        // 清理参数
-        if (!node->arguments.empty()) {
-            output << "    add $" << (node->arguments.size() * 8) << ", %rsp" << std::endl;
+        emit("idivq", b);
+        emitMove(instr.op == IROp::Div ? "%rax" : "%rdx", instr.dst);
+        return;
+    }
+
+    if (instr.isCompare()) {
+        const char* cc = conditionCode(emitCompare(instr));
+        if (inRegister(instr.dst)) {
+            int reg = allocation->location(instr.dst).reg;
+            emit(std::string("set") + cc, regName8(reg));
+            emit("movzbq", regName8(reg), d);
+        } else {
+            emit(std::string("set") + cc, "%al");
+            emit("movzbq", "%al", "%rax");
+            emit("movq", "%rax", d);
         }
+        return;
     }
-}
 
-void CodeGenerator::visit(ExpressionStatement* node) {
-    node->expression->accept(this);
+    bool isShift = instr.op == IROp::Shl || instr.op == IROp::Sar;
+    if (isShift && !isConstant(instr.b)) {
+        // 移位次数只能是立即数或%cl
+        emit("movq", a, "%rax");
+        emit("pushq", "%rcx");
+        emit("movq", b, "%rcx");
+        emit(instr.op == IROp::Shl ? "shlq" : "sarq", "%cl", "%rax");
+        emit("popq", "%rcx");
+        emitMove("%rax", instr.dst);
+        return;
+    }
+
+    const char* opInstr = instr.op == IROp::Add ? "addq" : instr.op == IROp::Sub ? "subq" :
+                          instr.op == IROp::Mul ? "imulq" : instr.op == IROp::And ? "andq" :
+                          instr.op == IROp::Or ? "orq" : instr.op == IROp::Shl ? "shlq" : "sarq";
+    bool commutative = instr.op != IROp::Sub && !isShift;
+
+    if (inRegister(instr.dst) && d == b && commutative) {
+        // d = a op d：交换操作数后原地计算
+        emit(opInstr, a, d);
+    } else if (inRegister(instr.dst) && d != b) {
+        if (d != a) {
+            emit("movq", a, d);
+        }
+        emit(opInstr, b, d);
+    } else {
+        // 目标在栈槽中，或 d = a - d：经由%rax计算
+        emit("movq", a, "%rax");
+        emit(opInstr, b, "%rax");
+        emit("movq", "%rax", d);
+    }
 }
 
-void CodeGenerator::visit(VariableDeclaration* node) {
-    // 处理普通变量声明
-    for (const auto& name : node->names) {
-        allocateVariable(name);
-        output << "    # Variable declaration: " << node->type << " " << name << std::endl;
-    }
-    
-    // 处理带初始化的变量声明
-    for (const auto& initDecl : node->initDeclarators) {
-        const std::string& name = initDecl.first;
-        const auto& initExpr = initDecl.second;
-        
-        // 分配变量空间
-        allocateVariable(name);
-        output << "    # Variable declaration with initialization: " << node->type << " " << name << std::endl;
-        
-        // 如果有初始化表达式，生成初始化代码
-        if (initExpr) {
-            initExpr->accept(this);
-            std::string address = getVariableAddress(name);
-            if (!address.empty()) {
-                output << "    movq %rax, " << address << std::endl;
+void FunctionGenerator::generateInstruction(const IRInstr& instr, int block, size_t index) {
+    const BasicBlock& bb = function->blocks[block];
+    int next = block + 1;
+
+    switch (instr.op) {
+        case IROp::Const:
+            if (!isConstant(instr.dst)) {
+                emit("movq", "$" + std::to_string(instr.imm), operand(instr.dst));
+            }
+            break;
+        case IROp::Copy:
+            emitMove(operand(instr.a), instr.dst);
+            break;
+        case IROp::Param:
+            // 入口处连续的param作为一组并行搬移
+            if (index == 0) {
+                int count = 0;
+                while (count < (int)bb.instrs.size() && bb.instrs[count].op == IROp::Param) {
+                    count++;
+                }
+                generateParams(count);
+            }
+            break;
+        case IROp::Neg:
+            if (inRegister(instr.dst) || operand(instr.dst) == operand(instr.a)) {
+                emitMove(operand(instr.a), instr.dst);
+                emit("negq", operand(instr.dst));
+            } else {
+                emit("movq", operand(instr.a), "%rax");
+                emit("negq", "%rax");
+                emit("movq", "%rax", operand(instr.dst));
+            }
+            break;
+        case IROp::Not:
+            if (isConstant(instr.a)) {
+                emitMove("$" + std::to_string(allocation->location(instr.a).value == 0), instr.dst);
+                break;
+            }
+            emit("cmpq", "$0", operand(instr.a));
+            emit("sete", "%al");
+            emit("movzbq", "%al", "%rax");
+            emitMove("%rax", instr.dst);
+            break;
+        case IROp::Call:
+            generateCall(instr);
+            break;
+        case IROp::Jump:
+            if (bb.succs[0] != next) {
+                emit("jmp", blockLabel(bb.succs[0]));
+            }
+            break;
+        case IROp::Branch: {
+            int trueBlock = bb.succs[0];
+            int falseBlock = bb.succs[1];
+            if (isConstant(instr.a)) {
+                int target = allocation->location(instr.a).value != 0 ? trueBlock : falseBlock;
+                if (target != next) {
+                    emit("jmp", blockLabel(target));
+                }
+                break;
             }
+            IROp compare = IROp::CmpNe;
+            if (index > 0 && fusesWithBranch(block, index - 1)) {
+                // 直接使用前一条比较设置的标志位
+                compare = emitCompare(bb.instrs[index - 1]);
+            } else if (inRegister(instr.a)) {
+                emit("testq", operand(instr.a), operand(instr.a));
+            } else {
+                emit("cmpq", "$0", operand(instr.a));
+            }
+            const char* cc = conditionCode(compare);
+            if (falseBlock == next) {
+                emit(std::string("j") + cc, blockLabel(trueBlock));
+            } else if (trueBlock == next) {
+                emit(std::string("j") + conditionCode(negateCompare(compare)), blockLabel(falseBlock));
+            } else {
+                emit(std::string("j") + cc, blockLabel(trueBlock));
+                emit("jmp", blockLabel(falseBlock));
+            }
+            break;
         }
+        case IROp::Return:
+            if (instr.a >= 0) {
+                emit("movq", operand(instr.a), "%rax");
+            }
+            generateFunctionEpilogue();
+            break;
+        default:
+            if (!fusesWithBranch(block, index)) {
+                generateBinary(instr);
+            }
+            break;
     }
 }
 
-void CodeGenerator::visit(CompoundStatement* node) {
-    for (const auto& stmt : node->statements) {
-        stmt->accept(this);
+std::string FunctionGenerator::generate(const IRFunction& func) {
+    function = &func;
+    frame.reset();
+    code.clear();
+
+    // 先分配寄存器（这会确定溢出需要的栈空间）
+    RegisterAllocator allocator(func, frame);
+    allocator.run();
+    allocation = &allocator;
+    useCounts.assign(func.vregCount, 0);
+    for (const auto& block : func.blocks) {
+        for (const auto& instr : block.instrs) {
+            forEachUse(func, instr, [&](int v) { useCounts[v]++; });
+        }
+    }
+    calleeSavedSlots.clear();
+    for (size_t i = 0; i < allocator.usedCalleeSavedRegisters().size(); i++) {
+        calleeSavedSlots.push_back(frame.allocateLocal());
     }
-}
 
-void CodeGenerator::visit(IfStatement* node) {
-    std::string falseLabel = generateLabel("if_false");
-    std::string endLabel = generateLabel("if_end");
-    
-    // 计算条件
-    node->condition->accept(this);
-    output << "    testq %rax, %rax" << std::endl;
-    output << "    je " << falseLabel << std::endl;
-    
-    // then分支
-    node->thenStmt->accept(this);
-    output << "    jmp " << endLabel << std::endl;
-    
-    // else分支
-    output << falseLabel << ":" << std::endl;
-    if (node->elseStmt) {
-        node->elseStmt->accept(this);
-    }
-    
-    output << endLabel << ":" << std::endl;
-}
+    for (size_t b = 0; b < func.blocks.size(); b++) {
+        if (b > 0) {
+            code.emplace_back(AsmKind::Label, blockLabel(b));
+        }
+        const auto& instrs = func.blocks[b].instrs;
+        for (size_t i = 0; i < instrs.size(); i++) {
+            generateInstruction(instrs[i], b, i);
+        }
+    }
+
+    if (optimize) {
+        peephole.run(code);
+    }
 
-void CodeGenerator::visit(WhileStatement* node) {
-    std::string loopLabel = generateLabel("while_loop");
-    std::string endLabel = generateLabel("while_end");
-    
-    output << loopLabel << ":" << std::endl;
-    
-    // 计算条件
-    node->condition->accept(this);
-    output << "    testq %rax, %rax" << std::endl;
-    output << "    je " << endLabel << std::endl;
-    
-    node->body->accept(this);
-    output << "    jmp " << loopLabel << std::endl;
-    
-    output << endLabel << ":" << std::endl;
+    // 栈帧大小已知，拼接前导码和函数体后整块写出
+    std::ostringstream prologue;
+    generateFunctionPrologue(prologue);
+    std::string text = prologue.str();
+    for (const auto& line : code) {
+        line.print(text);
+    }
+    text += '\n';
+
+    allocation = nullptr;
+    function = nullptr;
+    return text;
 }
 
-void CodeGenerator::visit(ForStatement* node) {
-    std::string loopLabel = generateLabel("for_loop");
-    std::string updateLabel = generateLabel("for_update");
-    std::string endLabel = generateLabel("for_end");
-    
-    // 初始化语法
-    if (node->init) {
-        node->init->accept(this);
-    }
-    
-    output << loopLabel << ":" << std::endl;
-    
-    // 条件检测
-    if (node->condition) {
-        node->condition->accept(this);
-        output << "    testq %rax, %rax" << std::endl;
-        output << "    je " << endLabel << std::endl;
-    }
-    
-
-    node->body->accept(this);
-    
-    // 更新表达式
-    output << updateLabel << ":" << std::endl;
-    if (node->update) {
-        node->update->accept(this);
-    }
-    
-    output << "    jmp " << loopLabel << std::endl;
-    output << endLabel << ":" << std::endl;
+CodeGenerator::CodeGenerator(OutputSink& out, bool optimize, unsigned jobs)
+    : sink(out), optimize(optimize), jobs(jobs) {
 }
 
-void CodeGenerator::visit(ReturnStatement* node) {
-    if (node->value) {
-        node->value->accept(this);
-    } else {
-        output << "    movq $0, %rax" << std::endl;
+void CodeGenerator::generateAssembly(IRProgram& program) {
+    // 生成汇编文件头部
+    sink.write("# Generated by C Compiler\n\n");
+
+    // 各函数互不依赖：IR优化和代码生成在同一任务中完成，文本先存入各自的槽位，
+    // 全部完成后按源程序顺序写出
+    size_t count = program.functions.size();
+    std::vector<std::string> texts(count);
+    std::vector<PeepholeOptimizer> stats(count);
+    parallelFor(count, jobs, [&](size_t i) {
+        IRFunction& func = program.functions[i];
+        if (optimize) {
+            Optimizer().run(func);
+        }
+        FunctionGenerator generator(optimize);
+        texts[i] = generator.generate(func);
+        stats[i] = generator.getPeephole();
+    });
+
+    for (size_t i = 0; i < count; i++) {
+        sink.write(texts[i]);
+        peephole.merge(stats[i]);
     }
-    output << "    leave" << std::endl;
-    output << "    ret" << std::endl;
 }
 
-void CodeGenerator::visit(FunctionDefinition* node) {
-    currentFunction = node->name;
-    symbolTable.clear();
-    stackOffset = 0;
-    
-    // 先生成函数标签
-    output << ".section .text" << std::endl;
-    output << ".globl " << node->name << std::endl;
-    output << node->name << ":" << std::endl;
-    output << "    pushq %rbp" << std::endl;
-    output << "    movq %rsp, %rbp" << std::endl;
-    
-    // 处理参数
-    int paramOffset = 16; 
-    for (const auto& param : node->parameters) {
-        symbolTable[param.second] = -paramOffset;
-        paramOffset += 8;
-    }
-    
-    // 生成函数体（这会计算需要的栈空间）
-    if (node->body) {
-        node->body->accept(this);
-    }
-    
-    // 分配栈空间（如果需要）
-    if (stackOffset > 0) {
-
-        output << "    # Stack space allocated: " << stackOffset << " bytes" << std::endl;
-    }
-    
-    // 生成函数结束标签
-    std::string endLabel = generateLabel("func_end");
-    output << endLabel << ":" << std::endl;
-    
-
-    output << "    # Default return (if no explicit return)" << std::endl;
-    if (node->returnType != "void") {
-        output << "    movq $0, %rax" << std::endl;
-    }
-    output << "    leave" << std::endl;
-    output << "    ret" << std::endl;
-    
-    output << std::endl;
-}
+size_t CodeGenerator::generateAssembly(Program* program, CompileCache& cache, const std::string& options,
+                                       std::string* irText) {
+    sink.write("# Generated by C Compiler\n\n");
 
-void CodeGenerator::visit(Program* node) {
-    // 生成汇编文件头部
-    output << "# Generated by C Compiler" << std::endl;
-    output << std::endl;
-    
-    // 处理所有声明
-    for (const auto& decl : node->declarations) {
-        decl->accept(this);
+    std::vector<FunctionDefinition*> functions;
+    for (const auto& decl : program->declarations) {
+        if (auto function = dynamic_cast<FunctionDefinition*>(decl)) {
+            functions.push_back(function);
+        }
+    }
+
+    // 每个函数的缓存条目保存汇编、优化后的IR和窥孔统计三段
+    size_t count = functions.size();
+    std::vector<CacheKey> keys(count);
+    std::vector<std::string> texts(count);
+    std::vector<std::string> irTexts(count);
+    std::vector<PeepholeOptimizer> stats(count);
+    std::vector<char> reused(count, 0);
+    parallelFor(count, jobs, [&](size_t i) {
+        std::string fingerprint = FunctionFingerprint::of(functions[i]);
+        keys[i] = CompileCache::key(fingerprint.data(), fingerprint.size(), options);
+        std::vector<std::pair<std::string, std::string>> sections = {{"asm", ""}, {"ir", ""}, {"peephole", ""}};
+        if (cache.lookup(keys[i], sections) && stats[i].mergeCounts(sections[2].second)) {
+            texts[i] = std::move(sections[0].second);
+            irTexts[i] = std::move(sections[1].second);
+            reused[i] = 1;
+        }
+    });
+
+    // 未命中的函数按源程序顺序降级（IRBuilder不可并发使用），再并行优化和生成
+    IRBuilder builder;
+    IRProgram ir;
+    std::vector<size_t> pending;
+    for (size_t i = 0; i < count; i++) {
+        if (!reused[i]) {
+            builder.build(functions[i], ir);
+            pending.push_back(i);
+        }
     }
+    parallelFor(pending.size(), jobs, [&](size_t k) {
+        size_t i = pending[k];
+        IRFunction& func = ir.functions[k];
+        if (optimize) {
+            Optimizer().run(func);
+        }
+        FunctionGenerator generator(optimize);
+        texts[i] = generator.generate(func);
+        stats[i] = generator.getPeephole();
+        std::ostringstream text;
+        func.print(text);
+        text << std::endl;
+        irTexts[i] = text.str();
+        cache.store(keys[i], {{"asm", texts[i]}, {"ir", irTexts[i]}, {"peephole", stats[i].saveCounts()}});
+    });
+
+    std::ostringstream irOut;
+    IRProgram::printBegin(irOut);
+    for (size_t i = 0; i < count; i++) {
+        sink.write(texts[i]);
+        peephole.merge(stats[i]);
+        irOut << irTexts[i];
+    }
+    IRProgram::printEnd(irOut);
+    if (irText) {
+        *irText = irOut.str();
+    }
+    return count - pending.size();
 }
 
 void CodeGenerator::generateAssembly(Program* program) {
     if (program) {
-        program->accept(this);
+        IRBuilder builder;
+        IRProgram ir = builder.build(program);
+        generateAssembly(ir);
     }
-} 
- 
\ No newline at end of file
+}
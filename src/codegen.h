@@ -2,57 +2,96 @@
 #define CODEGEN_H
 
 #include "ast.h"
-#include <fstream>
-#include <unordered_map>
+#include "ir.h"
+#include "output.h"
+#include "peephole.h"
+#include "regalloc.h"
+#include <sstream>
 #include <string>
 #include <vector>
 
-// x86汇编代码生成器
-class CodeGenerator : public Visitor {
+class CompileCache;
+
+// 单个函数的代码生成上下文：寄存器分配、栈帧、指令缓冲都只属于一个函数，
+// 标签以函数名为前缀，因此各函数可以在不同线程中各用一个实例同时生成
+class FunctionGenerator {
 private:
-    std::ostream& output;
-    std::unordered_map<std::string, int> symbolTable; // 变量名到栈偏移的映射
-    int stackOffset;        // 当前栈偏移
-    int labelCounter;       // 标签计数器
-    std::string currentFunction; // 当前函数名
-    
-    // 生成唯一标签
-    std::string generateLabel(const std::string& prefix = "L");
-    
-    // 分配栈空间给变量
-    void allocateVariable(const std::string& name);
-    
-    // 获取变量的栈地址
-    std::string getVariableAddress(const std::string& name);
-    
-    // 生成函数前导码
-    void generateFunctionPrologue(const std::string& funcName);
-    
+    std::vector<AsmInstr> code; // 当前函数体的指令缓冲（写出前经过窥孔优化）
+    const IRFunction* function; // 当前函数
+    const RegisterAllocator* allocation; // 当前函数的寄存器分配结果
+    FrameLayout frame;          // 当前函数的栈帧布局
+    std::vector<int> calleeSavedSlots; // 被调用者保存寄存器的保存槽位
+    bool optimize;              // 是否运行窥孔优化
+    std::vector<int> useCounts; // 当前函数各虚拟寄存器的使用次数
+    PeepholeOptimizer peephole; // 窥孔优化器（统计本实例生成的各函数累计）
+
+    // 追加一条指令
+    void emit(const std::string& opcode, const std::string& src = "", const std::string& dst = "");
+
+    // 基本块标签
+    std::string blockLabel(int block) const;
+
+    // 虚拟寄存器的汇编操作数（寄存器、栈地址或立即数）
+    std::string operand(int vreg) const;
+    bool inRegister(int vreg) const { return allocation->location(vreg).reg >= 0; }
+    bool isConstant(int vreg) const { return allocation->location(vreg).isConstant; }
+
+    // 生成函数前导码（保存被调用者保存寄存器）
+    void generateFunctionPrologue(std::ostream& target);
+
     // 生成函数后导码
     void generateFunctionEpilogue();
 
+    // 通用传送（内存到内存经由%rax）
+    void emitMove(const std::string& source, int dst);
+
+    // 并行传送：目标寄存器之间存在环时借助%rax打破
+    void emitParallelMoves(std::vector<std::pair<std::string, int>> moves);
+
+    // 比较结果只被紧随其后的分支使用时不必物化为0/1，直接按标志位跳转
+    bool fusesWithBranch(int block, size_t index) const;
+
+    // 生成cmp指令，返回交换操作数后实际对应的比较
+    IROp emitCompare(const IRInstr& instr);
+
+    void generateInstruction(const IRInstr& instr, int block, size_t index);
+    void generateBinary(const IRInstr& instr);
+    void generateCall(const IRInstr& instr);
+    void generateParams(int count);
+
 public:
-    CodeGenerator(std::ostream& out);
-    
-    // 访问者模式实现
-    void visit(IntegerLiteral* node) override;
-    void visit(Identifier* node) override;
-    void visit(BinaryExpression* node) override;
-    void visit(UnaryExpression* node) override;
-    void visit(AssignmentExpression* node) override;
-    void visit(FunctionCall* node) override;
-    void visit(ExpressionStatement* node) override;
-    void visit(VariableDeclaration* node) override;
-    void visit(CompoundStatement* node) override;
-    void visit(IfStatement* node) override;
-    void visit(WhileStatement* node) override;
-    void visit(ForStatement* node) override;
-    void visit(ReturnStatement* node) override;
-    void visit(FunctionDefinition* node) override;
-    void visit(Program* node) override;
-    
+    explicit FunctionGenerator(bool optimize = true);
+
+    // 生成一个函数的完整汇编文本
+    std::string generate(const IRFunction& func);
+
+    const PeepholeOptimizer& getPeephole() const { return peephole; }
+};
+
+// x86汇编代码生成器：AST先降级为IR，再为各函数并行做IR优化并生成汇编，
+// 结果按源程序中的函数顺序拼接后写出，与线程数无关
+class CodeGenerator {
+private:
+    OutputSink& sink;           // 汇编输出目标
+    bool optimize;              // 生成前是否运行IR优化
+    unsigned jobs;              // 并行生成函数的线程数
+    PeepholeOptimizer peephole; // 各函数窥孔优化统计的汇总
+
+public:
+    CodeGenerator(OutputSink& out, bool optimize = true, unsigned jobs = 1);
+
     // 生成汇编代码
     void generateAssembly(Program* program);
+    void generateAssembly(IRProgram& program);  // optimize时先逐函数优化IR
+
+    // 函数级增量生成：各函数以指纹（见fingerprint.h）为键在cache中查找此前生成的汇编，
+    // 命中的直接复用，只有未命中的函数降级为IR、优化并生成，结果写回cache。
+    // options为影响输出的编译选项；irText非空时按源程序顺序写出各函数优化后的IR
+    // （格式同IRProgram::print）。返回复用的函数数
+    size_t generateAssembly(Program* program, CompileCache& cache, const std::string& options,
+                            std::string* irText = nullptr);
+
+    const PeepholeOptimizer& getPeephole() const { return peephole; }
 };
 
-#endif // CODEGEN_H 
\ No newline at end of file
+#endif // CODEGEN_H
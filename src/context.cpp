@@ -0,0 +1,16 @@
+#include "context.h"
+#include "parser.tab.hpp"
+
+bool CompileContext::open(const std::string& path, ScannerKind kind) {
+    lexer.end();
+    source = SourceBuffer::open(path);
+    return source && lexer.begin(*source, kind);
+}
+
+bool CompileContext::parse() {
+    program = nullptr;
+    arena.release();
+    int result = yyparse(this);
+    lexer.end();
+    return result == 0;
+}
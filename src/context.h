@@ -0,0 +1,36 @@
+#ifndef CONTEXT_H
+#define CONTEXT_H
+
+#include "arena.h"
+#include "ast.h"
+#include "diagnostics.h"
+#include "scanner.h"
+#include "source.h"
+#include <memory>
+#include <string>
+
+// 一次编译的全部前端状态：诊断输出、源文件、词法分析器、语法树内存池和解析结果。
+// 词法/语法分析器都是可重入的，不使用全局变量，
+// 因此多个上下文可以在不同线程中同时编译各自的文件
+class CompileContext {
+public:
+    Diagnostics& diagnostics;   // 本次编译的错误信息输出
+    std::unique_ptr<SourceBuffer> source;
+    Lexer lexer;                // 在source之后声明，先于其析构
+    AstArena arena;             // 语法树所在的内存池，整棵树随上下文一起释放
+    Program* program;           // 语法分析结果
+
+    explicit CompileContext(Diagnostics& diagnostics) : diagnostics(diagnostics), lexer(diagnostics), program(nullptr) {}
+    CompileContext(const CompileContext&) = delete;
+    CompileContext& operator=(const CompileContext&) = delete;
+
+    // 映射源文件并让词法分析器在其上扫描
+    bool open(const std::string& path, ScannerKind kind);
+
+    // 执行语法分析（yyparse），成功时program指向语法树
+    bool parse();
+
+    int line() const { return lexer.line(); }
+};
+
+#endif // CONTEXT_H
@@ -0,0 +1,34 @@
+#include "diagnostics.h"
+#include <cstdarg>
+
+void Diagnostics::report(FILE* stream, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    if (!buffered) {
+        // 与std::cerr绑定std::cout一样，先写出标准输出中已有的内容，保持信息的先后顺序
+        if (stream == stderr) {
+            fflush(stdout);
+        }
+        vfprintf(stream, format, args);
+        va_end(args);
+        return;
+    }
+    va_list copy;
+    va_copy(copy, args);
+    int length = vsnprintf(nullptr, 0, format, copy);
+    va_end(copy);
+    std::string text(length > 0 ? length : 0, '\0');
+    if (length > 0) {
+        vsnprintf(&text[0], length + 1, format, args);
+    }
+    va_end(args);
+    entries.push_back({stream, std::move(text)});
+}
+
+void Diagnostics::flush() {
+    for (const Entry& entry : entries) {
+        fputs(entry.text.c_str(), entry.stream);
+        fflush(entry.stream);
+    }
+    entries.clear();
+}
@@ -0,0 +1,31 @@
+#ifndef DIAGNOSTICS_H
+#define DIAGNOSTICS_H
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// 诊断信息输出。单文件编译时直接写到指定的流（stdout/stderr）；
+// 批量编译时各文件分别缓存，全部完成后按输入顺序输出，使结果与线程调度无关
+class Diagnostics {
+private:
+    struct Entry {
+        FILE* stream;
+        std::string text;
+    };
+
+    bool buffered;
+    std::vector<Entry> entries;
+
+public:
+    explicit Diagnostics(bool buffered = false) : buffered(buffered) {}
+    Diagnostics(const Diagnostics&) = delete;
+    Diagnostics& operator=(const Diagnostics&) = delete;
+
+    void report(FILE* stream, const char* format, ...) __attribute__((format(printf, 3, 4)));
+
+    bool empty() const { return entries.empty(); }
+    void flush();   // 按记录顺序输出缓存的信息并清空
+};
+
+#endif // DIAGNOSTICS_H
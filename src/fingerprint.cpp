@@ -0,0 +1,170 @@
+#include "fingerprint.h"
+
+namespace {
+
+// 每个节点以一个标记字节开头，使序列化结果与树结构一一对应
+enum Tag : char {
+    kNull = 0, kLiteral, kIdentifier, kBinary, kUnary, kAssignment, kCall,
+    kExpressionStatement, kDeclaration, kCompound, kIf, kWhile, kFor, kReturn, kFunction
+};
+
+} // namespace
+
+std::string FunctionFingerprint::of(FunctionDefinition* function) {
+    FunctionFingerprint fingerprint;
+    function->accept(&fingerprint);
+    return std::move(fingerprint.bytes);
+}
+
+void FunctionFingerprint::add(int value) {
+    bytes.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void FunctionFingerprint::add(Name name) {
+    // 驻留编号只在本进程内有效，写入名字本身
+    const std::string& text = name.str();
+    add(static_cast<int>(text.size()));
+    bytes += text;
+}
+
+void FunctionFingerprint::add(TypeId type) {
+    add(static_cast<int>(type.index()));
+}
+
+void FunctionFingerprint::add(const SemanticInfo& info) {
+    add(info.type);
+    bytes += static_cast<char>(info.symbolKind);
+}
+
+void FunctionFingerprint::addExpression(Expression* expr) {
+    if (expr) {
+        expr->accept(this);
+    } else {
+        bytes += kNull;
+    }
+}
+
+void FunctionFingerprint::addStatement(Statement* stmt) {
+    if (stmt) {
+        stmt->accept(this);
+    } else {
+        bytes += kNull;
+    }
+}
+
+void FunctionFingerprint::visit(IntegerLiteral* node) {
+    bytes += kLiteral;
+    add(node->value);
+}
+
+void FunctionFingerprint::visit(Identifier* node) {
+    // 局部符号由槽位确定；全局符号（槽位为-1）还依赖其声明，记下种类和类型
+    bytes += kIdentifier;
+    add(node->name);
+    add(node->binding.slot);
+    add(node->semanticInfo);
+}
+
+void FunctionFingerprint::visit(BinaryExpression* node) {
+    bytes += kBinary;
+    bytes += static_cast<char>(node->op);
+    add(node->semanticInfo);
+    addExpression(node->left);
+    addExpression(node->right);
+}
+
+void FunctionFingerprint::visit(UnaryExpression* node) {
+    bytes += kUnary;
+    bytes += static_cast<char>(node->op);
+    add(node->semanticInfo);
+    addExpression(node->operand);
+}
+
+void FunctionFingerprint::visit(AssignmentExpression* node) {
+    bytes += kAssignment;
+    addExpression(node->left);
+    addExpression(node->right);
+}
+
+void FunctionFingerprint::visit(FunctionCall* node) {
+    // 被调函数的返回类型记在调用节点上
+    bytes += kCall;
+    add(node->name);
+    add(node->semanticInfo);
+    add(static_cast<int>(node->arguments.size()));
+    for (const auto& arg : node->arguments) {
+        addExpression(arg);
+    }
+}
+
+void FunctionFingerprint::visit(ExpressionStatement* node) {
+    bytes += kExpressionStatement;
+    addExpression(node->expression);
+}
+
+void FunctionFingerprint::visit(VariableDeclaration* node) {
+    bytes += kDeclaration;
+    add(node->type);
+    add(node->firstSlot);
+    add(static_cast<int>(node->names.size()));
+    for (const auto& name : node->names) {
+        add(name);
+    }
+    add(static_cast<int>(node->initDeclarators.size()));
+    for (const auto& initDecl : node->initDeclarators) {
+        add(initDecl.first);
+        addExpression(initDecl.second);
+    }
+}
+
+void FunctionFingerprint::visit(CompoundStatement* node) {
+    bytes += kCompound;
+    add(static_cast<int>(node->statements.size()));
+    for (const auto& stmt : node->statements) {
+        addStatement(stmt);
+    }
+}
+
+void FunctionFingerprint::visit(IfStatement* node) {
+    bytes += kIf;
+    addExpression(node->condition);
+    addStatement(node->thenStmt);
+    addStatement(node->elseStmt);
+}
+
+void FunctionFingerprint::visit(WhileStatement* node) {
+    bytes += kWhile;
+    addExpression(node->condition);
+    addStatement(node->body);
+}
+
+void FunctionFingerprint::visit(ForStatement* node) {
+    bytes += kFor;
+    addStatement(node->init);
+    addExpression(node->condition);
+    addExpression(node->update);
+    addStatement(node->body);
+}
+
+void FunctionFingerprint::visit(ReturnStatement* node) {
+    bytes += kReturn;
+    addExpression(node->value);
+}
+
+void FunctionFingerprint::visit(FunctionDefinition* node) {
+    bytes += kFunction;
+    add(node->returnType);
+    add(node->name);
+    add(node->frameSize);
+    add(static_cast<int>(node->parameters.size()));
+    for (const auto& param : node->parameters) {
+        add(param.first);
+        add(param.second);
+    }
+    addStatement(node->body);
+}
+
+void FunctionFingerprint::visit(Program* node) {
+    // 指纹以函数为单位，不对整个程序计算
+    (void)node;
+}
@@ -0,0 +1,43 @@
+#ifndef FINGERPRINT_H
+#define FINGERPRINT_H
+
+#include "ast.h"
+#include <string>
+
+// 函数指纹：把已完成语义分析的函数语法树按结构序列化为字节串，作为函数级增量编译的缓存键。
+// 其中包含影响代码生成的全部内容（结构、运算符、字面量、名字、类型、栈帧槽位），
+// 以及所引用的全局符号（被调函数、全局变量）的种类和类型，因此被引用符号的声明改变时
+// 引用方的指纹随之改变；行号、空白和注释不计入，只移动位置或修改注释的函数仍可复用
+class FunctionFingerprint : public Visitor {
+private:
+    std::string bytes;
+
+    void add(int value);
+    void add(Name name);
+    void add(TypeId type);
+    void add(const SemanticInfo& info);
+    void addExpression(Expression* expr);   // 可为空
+    void addStatement(Statement* stmt);     // 可为空
+
+public:
+    // 计算一个函数的指纹
+    static std::string of(FunctionDefinition* function);
+
+    void visit(IntegerLiteral* node) override;
+    void visit(Identifier* node) override;
+    void visit(BinaryExpression* node) override;
+    void visit(UnaryExpression* node) override;
+    void visit(AssignmentExpression* node) override;
+    void visit(FunctionCall* node) override;
+    void visit(ExpressionStatement* node) override;
+    void visit(VariableDeclaration* node) override;
+    void visit(CompoundStatement* node) override;
+    void visit(IfStatement* node) override;
+    void visit(WhileStatement* node) override;
+    void visit(ForStatement* node) override;
+    void visit(ReturnStatement* node) override;
+    void visit(FunctionDefinition* node) override;
+    void visit(Program* node) override;
+};
+
+#endif // FINGERPRINT_H
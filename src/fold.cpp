@@ -0,0 +1,258 @@
+#include "fold.h"
+#include <climits>
+#include <cstdint>
+
+namespace {
+
+// 除法/取模改写会复制被除数，只对规模不超过该值的无副作用表达式进行
+const int kMaxDuplicatedNodes = 4;
+
+const IntegerLiteral* asLiteral(const Expression* expr) {
+    return dynamic_cast<const IntegerLiteral*>(expr);
+}
+
+// 不含函数调用和赋值的表达式可以重复求值或直接丢弃
+bool isPure(const Expression* expr) {
+    if (dynamic_cast<const IntegerLiteral*>(expr) || dynamic_cast<const Identifier*>(expr)) {
+        return true;
+    }
+    if (auto binary = dynamic_cast<const BinaryExpression*>(expr)) {
+        return isPure(binary->left) && isPure(binary->right);
+    }
+    if (auto unary = dynamic_cast<const UnaryExpression*>(expr)) {
+        return isPure(unary->operand);
+    }
+    return false;
+}
+
+// 结果已经是0/1的表达式
+bool isBoolean(const Expression* expr) {
+    if (auto binary = dynamic_cast<const BinaryExpression*>(expr)) {
+        return isComparison(binary->op) || isLogical(binary->op);
+    }
+    if (auto unary = dynamic_cast<const UnaryExpression*>(expr)) {
+        return unary->op == UnaryOp::Not;
+    }
+    return false;
+}
+
+int countNodes(const Expression* expr) {
+    if (auto binary = dynamic_cast<const BinaryExpression*>(expr)) {
+        return 1 + countNodes(binary->left) + countNodes(binary->right);
+    }
+    if (auto unary = dynamic_cast<const UnaryExpression*>(expr)) {
+        return 1 + countNodes(unary->operand);
+    }
+    return 1;
+}
+
+// 正的2的幂返回指数，否则返回-1
+int powerOfTwo(int value) {
+    if (value <= 0 || (value & (value - 1)) != 0) {
+        return -1;
+    }
+    int shift = 0;
+    while ((1 << shift) != value) {
+        shift++;
+    }
+    return shift;
+}
+
+// 按int语义（32位回绕）求值；除零等未定义情况返回false
+bool evaluate(BinaryOp op, int a, int b, int& result) {
+    int64_t x = a, y = b, r;
+    switch (op) {
+        case BinaryOp::Add: r = x + y; break;
+        case BinaryOp::Sub: r = x - y; break;
+        case BinaryOp::Mul: r = x * y; break;
+        case BinaryOp::Div:
+        case BinaryOp::Mod:
+            if (y == 0 || (x == INT_MIN && y == -1)) {
+                return false;
+            }
+            r = op == BinaryOp::Div ? x / y : x % y;
+            break;
+        case BinaryOp::Eq: r = x == y; break;
+        case BinaryOp::Ne: r = x != y; break;
+        case BinaryOp::Lt: r = x < y; break;
+        case BinaryOp::Gt: r = x > y; break;
+        case BinaryOp::Le: r = x <= y; break;
+        case BinaryOp::Ge: r = x >= y; break;
+        case BinaryOp::LogicalAnd: r = x && y; break;
+        case BinaryOp::LogicalOr: r = x || y; break;
+        default: return false;
+    }
+    result = static_cast<int32_t>(static_cast<uint32_t>(r));
+    return true;
+}
+
+} // namespace
+
+Expression* ConstantFolder::clone(const Expression* expr) {
+    // 复制无副作用表达式（只含字面量、标识符和运算）
+    Expression* copy;
+    if (auto literal = dynamic_cast<const IntegerLiteral*>(expr)) {
+        copy = arena->make<IntegerLiteral>(literal->value);
+    } else if (auto identifier = dynamic_cast<const Identifier*>(expr)) {
+        Identifier* name = arena->make<Identifier>(identifier->name);
+        name->binding = identifier->binding;
+        copy = name;
+    } else if (auto binary = dynamic_cast<const BinaryExpression*>(expr)) {
+        copy = arena->make<BinaryExpression>(clone(binary->left), binary->op, clone(binary->right));
+    } else {
+        auto unary = static_cast<const UnaryExpression*>(expr);
+        copy = arena->make<UnaryExpression>(unary->op, clone(unary->operand));
+    }
+    copy->semanticInfo = expr->semanticInfo;
+    copy->lineNumber = expr->lineNumber;
+    return copy;
+}
+
+Expression* ConstantFolder::makeLiteral(int value, const ASTNode* origin) {
+    Expression* literal = arena->make<IntegerLiteral>(value);
+    literal->lineNumber = origin->lineNumber;
+    literal->semanticInfo.type = TypeKind::Int;
+    literal->semanticInfo.symbolKind = SymbolKind::Literal;
+    literal->semanticInfo.isInitialized = true;
+    return literal;
+}
+
+Expression* ConstantFolder::makeBinary(Expression* left, BinaryOp op, Expression* right,
+                                       const ASTNode* origin) {
+    Expression* binary = arena->make<BinaryExpression>(left, op, right);
+    binary->lineNumber = origin->lineNumber;
+    binary->semanticInfo.type = TypeKind::Int;
+    binary->semanticInfo.symbolKind = SymbolKind::Expression;
+    binary->semanticInfo.isInitialized = true;
+    return binary;
+}
+
+Expression* ConstantFolder::fold(Expression* expr, TypeId type) {
+    const Expression* original = expr;
+    Expression* result;
+
+    if (auto unary = dynamic_cast<UnaryExpression*>(expr)) {
+        const IntegerLiteral* literal = asLiteral(unary->operand);
+        if (!literal) {
+            return expr;
+        }
+        int value = literal->value;
+        if (unary->op == UnaryOp::Neg) {
+            value = static_cast<int32_t>(0u - static_cast<uint32_t>(value));
+        } else if (unary->op == UnaryOp::Not) {
+            value = !value;
+        }
+        result = makeLiteral(value, unary);
+    } else if (auto binary = dynamic_cast<BinaryExpression*>(expr)) {
+        result = foldBinary(binary, type);
+    } else {
+        return expr;
+    }
+
+    if (result != original) {
+        foldCount++;
+    }
+    return result;
+}
+
+Expression* ConstantFolder::foldBinary(BinaryExpression* node, TypeId type) {
+    BinaryOp op = node->op;
+    const IntegerLiteral* left = asLiteral(node->left);
+    const IntegerLiteral* right = asLiteral(node->right);
+
+    if (left && right) {
+        int value;
+        if (evaluate(op, left->value, right->value, value)) {
+            return makeLiteral(value, node);
+        }
+        return node;
+    }
+
+    // 逻辑运算：字面量一侧可能直接决定结果，否则只剩另一侧的真值
+    if (isLogical(op)) {
+        bool isAnd = op == BinaryOp::LogicalAnd;
+        auto truth = [&](Expression* expr) {
+            if (isBoolean(expr)) {
+                return expr;
+            }
+            return makeBinary(expr, BinaryOp::Ne, makeLiteral(0, node), node);
+        };
+        if (left) {
+            // 左侧先求值：0 && x、1 || x 不会求值x
+            if ((left->value != 0) != isAnd) {
+                return makeLiteral(isAnd ? 0 : 1, node);
+            }
+            return truth(node->right);
+        }
+        if (right) {
+            if ((right->value != 0) == isAnd) {
+                return truth(node->left);
+            }
+            if (isPure(node->left)) {
+                return makeLiteral(isAnd ? 0 : 1, node);
+            }
+        }
+        return node;
+    }
+
+    // 以下化简只对整型算术成立（浮点除法不能改成移位）
+    if (type != TypeKind::Int) {
+        return node;
+    }
+
+    if ((op == BinaryOp::Add || op == BinaryOp::Sub) && right && right->value == 0) {
+        return node->left;
+    }
+    if (op == BinaryOp::Add && left && left->value == 0) {
+        return node->right;
+    }
+
+    if (op == BinaryOp::Mul && (left || right)) {
+        int value = right ? right->value : left->value;
+        Expression* other = right ? node->left : node->right;
+        if (value == 1) {
+            return other;
+        }
+        if (value == 0 && isPure(other)) {
+            return makeLiteral(0, node);
+        }
+        int shift = powerOfTwo(value);
+        if (shift > 0) {
+            return makeBinary(other, BinaryOp::Shl, makeLiteral(shift, node), node);
+        }
+    }
+
+    if ((op == BinaryOp::Div || op == BinaryOp::Mod) && right) {
+        if (right->value == 1) {
+            if (op == BinaryOp::Div) {
+                return node->left;
+            }
+            if (isPure(node->left)) {
+                return makeLiteral(0, node);
+            }
+        }
+        int shift = powerOfTwo(right->value);
+        if (shift > 0 && isPure(node->left) && countNodes(node->left) <= kMaxDuplicatedNodes) {
+            return reduceDivision(node->left, op, shift, node);
+        }
+    }
+
+    return node;
+}
+
+Expression* ConstantFolder::reduceDivision(Expression* left, BinaryOp op, int shift,
+                                           const ASTNode* origin) {
+    // 有符号除法向零取整：负数先加上 2^k-1 再算术右移
+    //   x / 2^k = (x + ((x >> 31) & (2^k-1))) >> k
+    //   x % 2^k = x - ((x + ((x >> 31) & (2^k-1))) & -2^k)
+    int mask = (1 << shift) - 1;
+    auto sign = makeBinary(clone(left), BinaryOp::Sar, makeLiteral(31, origin), origin);
+    auto bias = makeBinary(sign, BinaryOp::BitAnd, makeLiteral(mask, origin), origin);
+    if (op == BinaryOp::Div) {
+        auto biased = makeBinary(left, BinaryOp::Add, bias, origin);
+        return makeBinary(biased, BinaryOp::Sar, makeLiteral(shift, origin), origin);
+    }
+    auto biased = makeBinary(clone(left), BinaryOp::Add, bias, origin);
+    auto rounded = makeBinary(biased, BinaryOp::BitAnd, makeLiteral(-(mask + 1), origin), origin);
+    return makeBinary(left, BinaryOp::Sub, rounded, origin);
+}
@@ -0,0 +1,36 @@
+#ifndef FOLD_H
+#define FOLD_H
+
+#include "ast.h"
+
+// AST级常量折叠与代数化简
+// 由语义分析在每个表达式分析完成后调用，子表达式此时已经折叠过，
+// 因此每次只需检查当前一层：
+//   - 字面量之间的运算直接求值（按int语义回绕，除零不折叠）
+//   - x+0、x-0、x*1、x/1 化简为 x；x*0、x%1 在 x 无副作用时化简为 0
+//   - 乘以2的幂改为左移；除以/取模2的幂改为移位和掩码（带负数修正）
+//   - 逻辑运算一侧为字面量时按短路语义化简
+// 新节点分配在语法树所在的内存池中，被替换下来的节点随内存池一起释放
+class ConstantFolder {
+private:
+    AstArena* arena;
+    int foldCount;  // 已改写的表达式数量
+
+    Expression* clone(const Expression* expr);
+    Expression* makeLiteral(int value, const ASTNode* origin);
+    Expression* makeBinary(Expression* left, BinaryOp op, Expression* right, const ASTNode* origin);
+    Expression* foldBinary(BinaryExpression* node, TypeId type);
+    Expression* reduceDivision(Expression* left, BinaryOp op, int shift, const ASTNode* origin);
+
+public:
+    ConstantFolder() : arena(nullptr), foldCount(0) {}
+
+    void setArena(AstArena* a) { arena = a; }
+
+    // 折叠expr，type为语义分析得到的表达式类型；返回替换后的表达式
+    Expression* fold(Expression* expr, TypeId type);
+
+    int getFoldCount() const { return foldCount; }
+};
+
+#endif // FOLD_H
@@ -0,0 +1,83 @@
+#include "intern.h"
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
+#include <string_view>
+#include <unordered_map>
+
+namespace {
+
+// 全局驻留表，可被多个编译线程同时使用。
+// 字符串按编号存放在定长分块中，块一经分配不再移动，块目录大小固定，
+// 因此 str() 不加锁；查找和插入由读写锁保护。
+struct NameTable {
+    static const uint32_t kChunkBits = 12;
+    static const uint32_t kChunkSize = 1u << kChunkBits;
+    static const uint32_t kMaxChunks = 1u << 14;
+
+    std::atomic<std::string*> chunks[kMaxChunks];
+    std::unordered_map<std::string_view, uint32_t> index;
+    uint32_t count;
+    std::shared_mutex mutex;
+
+    NameTable() : count(0) {
+        for (auto& chunk : chunks) {
+            chunk.store(nullptr, std::memory_order_relaxed);
+        }
+        add(std::string_view());  // 编号0为空串
+    }
+
+    ~NameTable() {
+        for (auto& chunk : chunks) {
+            delete[] chunk.load(std::memory_order_relaxed);
+        }
+    }
+
+    const std::string& at(uint32_t id) const {
+        return chunks[id >> kChunkBits].load(std::memory_order_acquire)[id & (kChunkSize - 1)];
+    }
+
+    // 调用者持有写锁
+    uint32_t add(std::string_view text) {
+        uint32_t id = count;
+        std::string* chunk = chunks[id >> kChunkBits].load(std::memory_order_relaxed);
+        if (!chunk) {
+            chunk = new std::string[kChunkSize];
+            chunks[id >> kChunkBits].store(chunk, std::memory_order_release);
+        }
+        std::string& slot = chunk[id & (kChunkSize - 1)];
+        slot.assign(text.data(), text.size());
+        index.emplace(slot, id);
+        count++;
+        return id;
+    }
+};
+
+NameTable& table() {
+    static NameTable instance;
+    return instance;
+}
+
+} // namespace
+
+Name Name::intern(const char* text, size_t length) {
+    NameTable& names = table();
+    std::string_view key(text, length);
+    {
+        std::shared_lock<std::shared_mutex> lock(names.mutex);
+        auto found = names.index.find(key);
+        if (found != names.index.end()) {
+            return Name(found->second);
+        }
+    }
+    std::unique_lock<std::shared_mutex> lock(names.mutex);
+    auto found = names.index.find(key);  // 等待写锁期间可能已被其他线程插入
+    if (found != names.index.end()) {
+        return Name(found->second);
+    }
+    return Name(names.add(key));
+}
+
+const std::string& Name::str() const {
+    return table().at(id);
+}
@@ -0,0 +1,44 @@
+#ifndef INTERN_H
+#define INTERN_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+
+// 驻留字符串：内容相同的标识符在全局表中只保存一份，用32位编号表示。
+// 比较和哈希都是整数运算；编号0固定为空串。驻留表可在多个线程中同时使用。
+// 默认构造不初始化（保持平凡类型以便放入Bison的%union），需要空名时用 Name() 值初始化。
+class Name {
+private:
+    uint32_t id;
+
+    explicit Name(uint32_t i) : id(i) {}
+
+public:
+    Name() = default;
+
+    static Name intern(const char* text, size_t length);
+    static Name intern(const std::string& text) { return intern(text.data(), text.size()); }
+
+    const std::string& str() const;
+    uint32_t index() const { return id; }
+    bool empty() const { return id == 0; }
+
+    bool operator==(Name other) const { return id == other.id; }
+    bool operator!=(Name other) const { return id != other.id; }
+};
+
+inline std::ostream& operator<<(std::ostream& out, Name name) {
+    return out << name.str();
+}
+
+namespace std {
+template<>
+struct hash<Name> {
+    size_t operator()(Name name) const { return name.index(); }
+};
+}
+
+#endif // INTERN_H
@@ -0,0 +1,606 @@
+#include "ir.h"
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+
+// IRFunction 实现
+int IRFunction::newVReg(const std::string& name) {
+    vregNames.push_back(name);
+    return vregCount++;
+}
+
+int IRFunction::addCallee(const std::string& callee) {
+    for (size_t i = 0; i < callees.size(); i++) {
+        if (callees[i] == callee) {
+            return i;
+        }
+    }
+    callees.push_back(callee);
+    return callees.size() - 1;
+}
+
+void IRFunction::rebuildCFG() {
+    // 从入口块出发标记可达块
+    std::vector<bool> reachable(blocks.size(), false);
+    std::vector<int> worklist = {0};
+    reachable[0] = true;
+    while (!worklist.empty()) {
+        int block = worklist.back();
+        worklist.pop_back();
+        for (int succ : blocks[block].succs) {
+            if (!reachable[succ]) {
+                reachable[succ] = true;
+                worklist.push_back(succ);
+            }
+        }
+    }
+
+    // 保持原有布局顺序压缩块数组
+    std::vector<int> order;
+    for (size_t i = 0; i < blocks.size(); i++) {
+        if (reachable[i]) {
+            order.push_back(i);
+        }
+    }
+    reorderBlocks(order);
+
+    for (auto& block : blocks) {
+        block.preds.clear();
+    }
+    for (size_t i = 0; i < blocks.size(); i++) {
+        for (int succ : blocks[i].succs) {
+            blocks[succ].preds.push_back(i);
+        }
+    }
+
+    // phi只保留来自当前前驱的输入
+    for (auto& block : blocks) {
+        for (auto& instr : block.instrs) {
+            if (instr.op != IROp::Phi) {
+                continue;
+            }
+            int kept = 0;
+            for (int i = 0; i < instr.b; i++) {
+                const PhiInput& input = phiInputs[instr.a + i];
+                if (std::find(block.preds.begin(), block.preds.end(), input.block) != block.preds.end()) {
+                    phiInputs[instr.a + kept++] = input;
+                }
+            }
+            instr.b = kept;
+        }
+    }
+}
+
+void IRFunction::reorderBlocks(const std::vector<int>& order) {
+    std::vector<int> newIndex(blocks.size(), -1);
+    std::vector<BasicBlock> ordered;
+    ordered.reserve(order.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        newIndex[order[i]] = i;
+        ordered.push_back(std::move(blocks[order[i]]));
+    }
+    blocks = std::move(ordered);
+
+    for (auto& block : blocks) {
+        for (int& succ : block.succs) {
+            succ = newIndex[succ];
+        }
+        for (int& pred : block.preds) {
+            pred = newIndex[pred];
+        }
+        block.preds.erase(std::remove(block.preds.begin(), block.preds.end(), -1), block.preds.end());
+    }
+    // 来自被丢弃块的phi输入标记为-1，由rebuildCFG清理
+    for (auto& input : phiInputs) {
+        if (input.block >= 0) {
+            input.block = newIndex[input.block];
+        }
+    }
+}
+
+void IRFunction::compactVRegs() {
+    std::vector<int> newIndex(vregCount, -1);
+    int count = 0;
+    auto number = [&](int v) {
+        if (newIndex[v] < 0) {
+            newIndex[v] = count++;
+        }
+    };
+    for (auto& block : blocks) {
+        for (auto& instr : block.instrs) {
+            forEachUse(*this, instr, number);
+            if (instr.dst >= 0) {
+                number(instr.dst);
+            }
+        }
+    }
+
+    for (auto& block : blocks) {
+        for (auto& instr : block.instrs) {
+            replaceUses(*this, instr, newIndex);
+            if (instr.dst >= 0) {
+                instr.dst = newIndex[instr.dst];
+            }
+        }
+    }
+    std::vector<std::string> names(count);
+    for (int v = 0; v < vregCount; v++) {
+        if (newIndex[v] >= 0) {
+            names[newIndex[v]] = vregNames[v];
+        }
+    }
+    vregNames = std::move(names);
+    vregCount = count;
+}
+
+void replaceUses(IRFunction& func, IRInstr& instr, const std::vector<int>& map) {
+    forEachUseRef(func, instr, [&](int& v) {
+        if (map[v] >= 0) {
+            v = map[v];
+        }
+    });
+}
+
+const char* irOpName(IROp op) {
+    switch (op) {
+        case IROp::Const: return "const";
+        case IROp::Copy: return "copy";
+        case IROp::Param: return "param";
+        case IROp::Add: return "add";
+        case IROp::Sub: return "sub";
+        case IROp::Mul: return "mul";
+        case IROp::Div: return "div";
+        case IROp::Mod: return "mod";
+        case IROp::And: return "and";
+        case IROp::Or: return "or";
+        case IROp::Shl: return "shl";
+        case IROp::Sar: return "sar";
+        case IROp::CmpEq: return "cmpeq";
+        case IROp::CmpNe: return "cmpne";
+        case IROp::CmpLt: return "cmplt";
+        case IROp::CmpGt: return "cmpgt";
+        case IROp::CmpLe: return "cmple";
+        case IROp::CmpGe: return "cmpge";
+        case IROp::Neg: return "neg";
+        case IROp::Not: return "not";
+        case IROp::Call: return "call";
+        case IROp::Phi: return "phi";
+        case IROp::Jump: return "jump";
+        case IROp::Branch: return "branch";
+        case IROp::Return: return "return";
+    }
+    return "?";
+}
+
+void IRFunction::print(std::ostream& out) const {
+    auto vreg = [this](int v) {
+        std::string text = "v" + std::to_string(v);
+        if (!vregNames[v].empty()) {
+            text += "(" + vregNames[v] + ")";
+        }
+        return text;
+    };
+
+    out << "函数 " << name << " (参数 " << paramCount << " 个, 虚拟寄存器 " << vregCount << " 个)" << std::endl;
+    for (size_t i = 0; i < blocks.size(); i++) {
+        const BasicBlock& block = blocks[i];
+        out << "bb" << i << " [" << block.name << "]  前驱:";
+        for (int pred : block.preds) {
+            out << " bb" << pred;
+        }
+        out << std::endl;
+
+        for (const auto& instr : block.instrs) {
+            out << "    ";
+            if (instr.dst >= 0) {
+                out << vreg(instr.dst) << " = ";
+            }
+            out << irOpName(instr.op);
+            if (instr.op == IROp::Const || instr.op == IROp::Param) {
+                out << " " << instr.imm;
+            } else if (instr.op == IROp::Call) {
+                out << " " << callees[instr.imm] << "(";
+                for (int k = 0; k < instr.b; k++) {
+                    out << (k ? ", " : "") << vreg(callArgs[instr.a + k]);
+                }
+                out << ")";
+            } else if (instr.op == IROp::Phi) {
+                for (int k = 0; k < instr.b; k++) {
+                    const PhiInput& input = phiInputs[instr.a + k];
+                    out << (k ? ", " : " ") << "[bb" << input.block << ": " << vreg(input.value) << "]";
+                }
+            } else {
+                bool first = true;
+                forEachUse(*this, instr, [&](int v) {
+                    out << (first ? " " : ", ") << vreg(v);
+                    first = false;
+                });
+            }
+            for (size_t k = 0; instr.isTerminator() && k < block.succs.size(); k++) {
+                out << (k || instr.op == IROp::Branch ? ", " : " ") << "bb" << block.succs[k];
+            }
+            out << std::endl;
+        }
+    }
+}
+
+void IRProgram::print(std::ostream& out) const {
+    printBegin(out);
+    for (const auto& func : functions) {
+        func.print(out);
+        out << std::endl;
+    }
+    printEnd(out);
+}
+
+void IRProgram::printBegin(std::ostream& out) {
+    out << "\n=== 中间表示（IR） ===" << std::endl;
+}
+
+void IRProgram::printEnd(std::ostream& out) {
+    out << "======================" << std::endl;
+}
+
+// IRBuilder 实现
+int IRBuilder::newBlock(const std::string& name) {
+    function->blocks.emplace_back(name);
+    return function->blocks.size() - 1;
+}
+
+void IRBuilder::setInsertBlock(int block) {
+    currentBlock = block;
+    if (std::find(placement.begin(), placement.end(), block) == placement.end()) {
+        placement.push_back(block);
+    }
+}
+
+void IRBuilder::layoutBlocks() {
+    // 块按创建顺序编号，嵌套语句的块会排在外层结束块之后；
+    // 这里改为按开始生成的顺序排列，使控制流尽量顺序落下
+    function->reorderBlocks(placement);
+    placement.clear();
+}
+
+void IRBuilder::emit(const IRInstr& instr) {
+    function->blocks[currentBlock].instrs.push_back(instr);
+}
+
+void IRBuilder::emitJump(int target) {
+    emit(IRInstr(IROp::Jump));
+    function->blocks[currentBlock].succs = {target};
+}
+
+void IRBuilder::emitBranch(int cond, int trueBlock, int falseBlock) {
+    emit(IRInstr(IROp::Branch, -1, cond));
+    function->blocks[currentBlock].succs = {trueBlock, falseBlock};
+}
+
+int IRBuilder::lowerExpression(Expression* expr) {
+    expr->accept(this);
+    return currentValue;
+}
+
+void IRBuilder::lowerCondition(Expression* expr, int trueBlock, int falseBlock) {
+    // 条件直接转为跳转：逻辑运算按短路语义拆成多个块，!交换目标块
+    if (auto binary = dynamic_cast<BinaryExpression*>(expr)) {
+        if (isLogical(binary->op)) {
+            bool isAnd = binary->op == BinaryOp::LogicalAnd;
+            int rhsBlock = newBlock(isAnd ? "and_rhs" : "or_rhs");
+            lowerCondition(binary->left, isAnd ? rhsBlock : trueBlock, isAnd ? falseBlock : rhsBlock);
+            setInsertBlock(rhsBlock);
+            lowerCondition(binary->right, trueBlock, falseBlock);
+            return;
+        }
+    } else if (auto unary = dynamic_cast<UnaryExpression*>(expr)) {
+        if (unary->op == UnaryOp::Not) {
+            lowerCondition(unary->operand, falseBlock, trueBlock);
+            return;
+        }
+    } else if (auto literal = dynamic_cast<IntegerLiteral*>(expr)) {
+        emitJump(literal->value != 0 ? trueBlock : falseBlock);
+        return;
+    }
+    emitBranch(lowerExpression(expr), trueBlock, falseBlock);
+}
+
+int* IRBuilder::cachedSymbol(int symbol) {
+    if (symbol < 0) {
+        return nullptr;
+    }
+    if (symbolCache.size() <= static_cast<size_t>(symbol)) {
+        symbolCache.resize(symbol + 1, std::make_pair(-1, -1));
+    }
+    auto& entry = symbolCache[symbol];
+    if (entry.first != functionCount) {
+        entry = std::make_pair(functionCount, -1);
+    }
+    return &entry.second;
+}
+
+int IRBuilder::lookupVariable(const Identifier* node) {
+    int slot = node->binding.slot;
+    if (slot >= 0) {
+        // 声明的初始化式中引用自身时，变量在声明语句写入前就被读取
+        return frame[slot] >= 0 ? frame[slot] : declareVariable(slot, node->name);
+    }
+    // 全局变量暂不支持代码生成：每个函数中以一个未赋值的寄存器代替
+    int* cached = cachedSymbol(node->binding.symbol);
+    if (cached && *cached >= 0) {
+        return *cached;
+    }
+    int vreg = function->newVReg(node->name.str());
+    if (cached) {
+        *cached = vreg;
+    }
+    return vreg;
+}
+
+int IRBuilder::declareVariable(int slot, Name name) {
+    if (frame[slot] < 0) {
+        frame[slot] = function->newVReg(name.str());
+    }
+    return frame[slot];
+}
+
+IRProgram IRBuilder::build(Program* node) {
+    IRProgram result;
+    program = &result;
+    node->accept(this);
+    program = nullptr;
+    return result;
+}
+
+void IRBuilder::build(FunctionDefinition* node, IRProgram& result) {
+    program = &result;
+    node->accept(this);
+    program = nullptr;
+}
+
+void IRBuilder::visit(IntegerLiteral* node) {
+    currentValue = function->newVReg();
+    emit(IRInstr(IROp::Const, currentValue, -1, -1, node->value));
+}
+
+void IRBuilder::visit(Identifier* node) {
+    currentValue = lookupVariable(node);
+}
+
+void IRBuilder::visit(BinaryExpression* node) {
+    BinaryOp op = node->op;
+    if (isLogical(op)) {
+        // 短路求值：按条件跳转到分别写入1/0的块再汇合
+        int result = function->newVReg();
+        int trueBlock = newBlock("logic_true");
+        int falseBlock = newBlock("logic_false");
+        int endBlock = newBlock("logic_end");
+        lowerCondition(node, trueBlock, falseBlock);
+        setInsertBlock(trueBlock);
+        emit(IRInstr(IROp::Const, result, -1, -1, 1));
+        emitJump(endBlock);
+        setInsertBlock(falseBlock);
+        emit(IRInstr(IROp::Const, result, -1, -1, 0));
+        emitJump(endBlock);
+        setInsertBlock(endBlock);
+        currentValue = result;
+        return;
+    }
+
+    int left = lowerExpression(node->left);
+    int right = lowerExpression(node->right);
+    int result = function->newVReg();
+
+    IROp irOp;
+    switch (op) {
+        case BinaryOp::Add: irOp = IROp::Add; break;
+        case BinaryOp::Sub: irOp = IROp::Sub; break;
+        case BinaryOp::Mul: irOp = IROp::Mul; break;
+        case BinaryOp::Div: irOp = IROp::Div; break;
+        case BinaryOp::Mod: irOp = IROp::Mod; break;
+        case BinaryOp::BitAnd: irOp = IROp::And; break;
+        case BinaryOp::Shl: irOp = IROp::Shl; break;
+        case BinaryOp::Sar: irOp = IROp::Sar; break;
+        case BinaryOp::Eq: irOp = IROp::CmpEq; break;
+        case BinaryOp::Ne: irOp = IROp::CmpNe; break;
+        case BinaryOp::Lt: irOp = IROp::CmpLt; break;
+        case BinaryOp::Gt: irOp = IROp::CmpGt; break;
+        case BinaryOp::Le: irOp = IROp::CmpLe; break;
+        case BinaryOp::Ge: irOp = IROp::CmpGe; break;
+        default:
+            // 逻辑与/或已在上面按短路求值降级，其余运算符都应在上面列出
+            std::cerr << "内部错误: IR生成遇到未处理的二元运算符 " << static_cast<int>(op) << std::endl;
+            std::abort();
+    }
+    emit(IRInstr(irOp, result, left, right));
+    currentValue = result;
+}
+
+void IRBuilder::visit(UnaryExpression* node) {
+    int operand = lowerExpression(node->operand);
+    currentValue = function->newVReg();
+    emit(IRInstr(node->op == UnaryOp::Neg ? IROp::Neg : IROp::Not, currentValue, operand));
+}
+
+void IRBuilder::visit(AssignmentExpression* node) {
+    int value = lowerExpression(node->right);
+    int variable = lookupVariable(node->left);
+    emit(IRInstr(IROp::Copy, variable, value));
+    currentValue = variable;
+}
+
+void IRBuilder::visit(FunctionCall* node) {
+    // printf暂不支持，结果视为0
+    static const Name printfName = Name::intern("printf");
+    if (node->name == printfName) {
+        currentValue = function->newVReg();
+        emit(IRInstr(IROp::Const, currentValue, -1, -1, 0));
+        return;
+    }
+
+    std::vector<int> args;
+    for (const auto& arg : node->arguments) {
+        args.push_back(lowerExpression(arg));
+    }
+    int argBegin = function->callArgs.size();
+    function->callArgs.insert(function->callArgs.end(), args.begin(), args.end());
+    int calleeIndex;
+    int* cached = cachedSymbol(node->binding.symbol);
+    if (cached && *cached >= 0) {
+        calleeIndex = *cached;
+    } else {
+        calleeIndex = function->addCallee(node->name.str());
+        if (cached) {
+            *cached = calleeIndex;
+        }
+    }
+    currentValue = function->newVReg();
+    emit(IRInstr(IROp::Call, currentValue, argBegin, args.size(), calleeIndex));
+}
+
+void IRBuilder::visit(ExpressionStatement* node) {
+    lowerExpression(node->expression);
+}
+
+void IRBuilder::visit(VariableDeclaration* node) {
+    int slot = node->firstSlot;
+    for (const auto& name : node->names) {
+        declareVariable(slot++, name);
+    }
+
+    for (const auto& initDecl : node->initDeclarators) {
+        // 初始化表达式中的名字已由语义分析解析，求值顺序不影响引用的是哪个变量
+        int value = initDecl.second ? lowerExpression(initDecl.second) : -1;
+        int variable = declareVariable(slot++, initDecl.first);
+        if (value >= 0) {
+            emit(IRInstr(IROp::Copy, variable, value));
+        }
+    }
+}
+
+void IRBuilder::visit(CompoundStatement* node) {
+    for (const auto& stmt : node->statements) {
+        stmt->accept(this);
+    }
+}
+
+void IRBuilder::visit(IfStatement* node) {
+    int thenBlock = newBlock("if_then");
+    int elseBlock = node->elseStmt ? newBlock("if_else") : -1;
+    int endBlock = newBlock("if_end");
+
+    lowerCondition(node->condition, thenBlock, elseBlock >= 0 ? elseBlock : endBlock);
+
+    setInsertBlock(thenBlock);
+    node->thenStmt->accept(this);
+    emitJump(endBlock);
+
+    if (elseBlock >= 0) {
+        setInsertBlock(elseBlock);
+        node->elseStmt->accept(this);
+        emitJump(endBlock);
+    }
+
+    setInsertBlock(endBlock);
+}
+
+void IRBuilder::visit(WhileStatement* node) {
+    int condBlock = newBlock("while_loop");
+    int bodyBlock = newBlock("while_body");
+    int endBlock = newBlock("while_end");
+
+    emitJump(condBlock);
+    setInsertBlock(condBlock);
+    lowerCondition(node->condition, bodyBlock, endBlock);
+
+    setInsertBlock(bodyBlock);
+    node->body->accept(this);
+    emitJump(condBlock);
+
+    setInsertBlock(endBlock);
+}
+
+void IRBuilder::visit(ForStatement* node) {
+    if (node->init) {
+        node->init->accept(this);
+    }
+
+    int condBlock = newBlock("for_loop");
+    int bodyBlock = newBlock("for_body");
+    int updateBlock = newBlock("for_update");
+    int endBlock = newBlock("for_end");
+
+    emitJump(condBlock);
+    setInsertBlock(condBlock);
+    if (node->condition) {
+        lowerCondition(node->condition, bodyBlock, endBlock);
+    } else {
+        emitJump(bodyBlock);
+    }
+
+    setInsertBlock(bodyBlock);
+    node->body->accept(this);
+    emitJump(updateBlock);
+
+    setInsertBlock(updateBlock);
+    if (node->update) {
+        lowerExpression(node->update);
+    }
+    emitJump(condBlock);
+
+    setInsertBlock(endBlock);
+}
+
+void IRBuilder::visit(ReturnStatement* node) {
+    int value = node->value ? lowerExpression(node->value) : -1;
+    if (value < 0 && function->returnsValue) {
+        value = function->newVReg();
+        emit(IRInstr(IROp::Const, value, -1, -1, 0));
+    }
+    emit(IRInstr(IROp::Return, -1, value));
+
+    // return 之后的语句不可达，放入单独的块中，构建CFG时删除
+    setInsertBlock(newBlock("unreachable"));
+}
+
+void IRBuilder::visit(FunctionDefinition* node) {
+    program->functions.emplace_back();
+    function = &program->functions.back();
+    function->name = node->name.str();
+    function->returnsValue = node->returnType != TypeKind::Void;
+    function->paramCount = node->parameters.size();
+
+    frame.assign(node->frameSize, -1);
+    setInsertBlock(newBlock("entry"));
+
+    // 参数按序定义为虚拟寄存器
+    for (size_t i = 0; i < node->parameters.size(); i++) {
+        int vreg = declareVariable(i, node->parameters[i].second);
+        emit(IRInstr(IROp::Param, vreg, -1, -1, i));
+    }
+
+    if (node->body) {
+        node->body->accept(this);
+    }
+
+    // 缺省返回（函数末尾没有return时）
+    int value = -1;
+    if (function->returnsValue) {
+        value = function->newVReg();
+        emit(IRInstr(IROp::Const, value, -1, -1, 0));
+    }
+    emit(IRInstr(IROp::Return, -1, value));
+
+    layoutBlocks();
+    function->rebuildCFG();
+    frame.clear();
+    functionCount++;
+    function = nullptr;
+}
+
+void IRBuilder::visit(Program* node) {
+    // 只降级函数定义；全局变量暂不支持代码生成
+    for (const auto& decl : node->declarations) {
+        if (dynamic_cast<FunctionDefinition*>(decl)) {
+            decl->accept(this);
+        }
+    }
+}
@@ -0,0 +1,204 @@
+#ifndef IR_H
+#define IR_H
+
+#include "ast.h"
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// 三地址中间表示（IR）
+// 所有值都是函数内编号的虚拟寄存器（局部变量和临时值不作区分），
+// 指令按基本块存放在连续数组中，块之间通过下标表示控制流边。
+
+enum class IROp : unsigned char {
+    Const,      // dst = imm
+    Copy,       // dst = a
+    Param,      // dst = 第imm个参数
+    Add, Sub, Mul, Div, Mod,    // dst = a op b
+    And, Or,                    // dst = a & b / a | b（按位运算）
+    Shl, Sar,                   // dst = a << b / a >> b（算术右移）
+    CmpEq, CmpNe, CmpLt, CmpGt, CmpLe, CmpGe,  // dst = (a cmp b) ? 1 : 0
+    Neg,        // dst = -a
+    Not,        // dst = !a
+    Call,       // dst = 函数callees[imm](callArgs[a .. a+b))
+    Phi,        // dst = phi(phiInputs[a .. a+b))，只出现在SSA形式的块首
+    Jump,       // 跳转到 succs[0]
+    Branch,     // a != 0 时跳转到 succs[0]，否则跳转到 succs[1]
+    Return,     // 返回 a（a < 0 表示无返回值）
+};
+
+struct IRInstr {
+    IROp op;
+    int dst;    // 目标虚拟寄存器，无结果时为-1
+    int a;      // 第一个源操作数（Call/Phi时为区间起点）
+    int b;      // 第二个源操作数（Call/Phi时为区间长度）
+    int imm;    // 常量值、参数序号或被调函数下标
+
+    IRInstr(IROp o, int d = -1, int x = -1, int y = -1, int i = 0)
+        : op(o), dst(d), a(x), b(y), imm(i) {}
+
+    bool isTerminator() const {
+        return op == IROp::Jump || op == IROp::Branch || op == IROp::Return;
+    }
+    bool isBinary() const { return op >= IROp::Add && op <= IROp::CmpGe; }
+    bool isCompare() const { return op >= IROp::CmpEq && op <= IROp::CmpGe; }
+};
+
+// 基本块：以一条终结指令结束的线性指令序列
+struct BasicBlock {
+    std::string name;           // 标签提示（if_false、while_loop等）
+    std::vector<IRInstr> instrs;
+    std::vector<int> succs;     // 后继块下标（Branch时依次为真/假分支）
+    std::vector<int> preds;     // 前驱块下标
+
+    explicit BasicBlock(const std::string& n) : name(n) {}
+
+    const IRInstr* terminator() const {
+        return !instrs.empty() && instrs.back().isTerminator() ? &instrs.back() : nullptr;
+    }
+};
+
+// phi的一个输入：从前驱块block流入时取值value
+struct PhiInput {
+    int block;
+    int value;
+};
+
+// 函数级IR，blocks[0]为入口块，下标顺序即代码布局顺序
+struct IRFunction {
+    std::string name;
+    bool returnsValue;
+    int paramCount;
+    int vregCount;
+    std::vector<BasicBlock> blocks;
+    std::vector<std::string> vregNames;    // 变量名（临时值为空）
+    std::vector<int> callArgs;             // 所有调用的实参，Call指令按区间引用
+    std::vector<std::string> callees;      // 被调函数名表
+    std::vector<PhiInput> phiInputs;       // 所有phi的输入，Phi指令按区间引用
+
+    IRFunction() : returnsValue(true), paramCount(0), vregCount(0) {}
+
+    int newVReg(const std::string& name = "");
+    int addCallee(const std::string& callee);
+
+    // 依据终结指令重建前驱/后继关系，并删除不可达块
+    // （phi中来自已不是前驱的块的输入一并删除）
+    void rebuildCFG();
+
+    // 按order给出的旧下标顺序重排基本块（order中未出现的块被丢弃）
+    void reorderBlocks(const std::vector<int>& order);
+
+    // 重新紧凑编号仍被使用的虚拟寄存器
+    void compactVRegs();
+
+    void print(std::ostream& out = std::cout) const;
+};
+
+// 遍历指令读取的所有虚拟寄存器（可原地修改）
+template<typename F>
+void forEachUseRef(IRFunction& func, IRInstr& instr, F fn) {
+    switch (instr.op) {
+        case IROp::Const:
+        case IROp::Param:
+        case IROp::Jump:
+            break;
+        case IROp::Call:
+            for (int i = 0; i < instr.b; i++) {
+                fn(func.callArgs[instr.a + i]);
+            }
+            break;
+        case IROp::Phi:
+            for (int i = 0; i < instr.b; i++) {
+                fn(func.phiInputs[instr.a + i].value);
+            }
+            break;
+        case IROp::Copy:
+        case IROp::Neg:
+        case IROp::Not:
+        case IROp::Branch:
+            fn(instr.a);
+            break;
+        case IROp::Return:
+            if (instr.a >= 0) {
+                fn(instr.a);
+            }
+            break;
+        default:
+            fn(instr.a);
+            fn(instr.b);
+            break;
+    }
+}
+
+// 遍历指令读取的所有虚拟寄存器
+template<typename F>
+void forEachUse(const IRFunction& func, const IRInstr& instr, F fn) {
+    forEachUseRef(const_cast<IRFunction&>(func), const_cast<IRInstr&>(instr), [&](int v) { fn(v); });
+}
+
+// 把指令读取的虚拟寄存器按map替换（map[v] < 0 表示保持不变）
+void replaceUses(IRFunction& func, IRInstr& instr, const std::vector<int>& map);
+
+const char* irOpName(IROp op);
+
+struct IRProgram {
+    std::vector<IRFunction> functions;
+
+    void print(std::ostream& out = std::cout) const;
+
+    // print() 输出的首尾两行；函数逐个输出时（如取自缓存）用于拼出相同的格式
+    static void printBegin(std::ostream& out);
+    static void printEnd(std::ostream& out);
+};
+
+// AST到IR的降级
+class IRBuilder : public Visitor {
+private:
+    IRProgram* program;
+    IRFunction* function;       // 当前函数
+    int currentBlock;           // 当前插入块
+    int currentValue;           // 最近一个表达式的结果寄存器
+    std::vector<int> placement; // 块首次成为插入点的顺序，即最终布局顺序
+    std::vector<int> frame;     // 栈帧槽位到虚拟寄存器（-1表示尚未分配）
+    int functionCount;          // 已降级的函数数
+    // 按符号序号记录本函数中的结果：被调函数在callees中的下标，或全局变量对应的寄存器。
+    // 每项带有写入时的函数序号，换到下一个函数时不必清空
+    std::vector<std::pair<int, int>> symbolCache;
+
+    int newBlock(const std::string& name);
+    void setInsertBlock(int block);
+    void layoutBlocks();
+    void emit(const IRInstr& instr);
+    void emitJump(int target);
+    void emitBranch(int cond, int trueBlock, int falseBlock);
+    int lowerExpression(Expression* expr);
+    void lowerCondition(Expression* expr, int trueBlock, int falseBlock);
+    int* cachedSymbol(int symbol);
+    int lookupVariable(const Identifier* node);
+    int declareVariable(int slot, Name name);
+
+public:
+    IRBuilder() : program(nullptr), function(nullptr), currentBlock(0), currentValue(-1), functionCount(0) {}
+
+    IRProgram build(Program* node);
+    void build(FunctionDefinition* node, IRProgram& result);  // 只降级一个函数，追加到result末尾
+
+    void visit(IntegerLiteral* node) override;
+    void visit(Identifier* node) override;
+    void visit(BinaryExpression* node) override;
+    void visit(UnaryExpression* node) override;
+    void visit(AssignmentExpression* node) override;
+    void visit(FunctionCall* node) override;
+    void visit(ExpressionStatement* node) override;
+    void visit(VariableDeclaration* node) override;
+    void visit(CompoundStatement* node) override;
+    void visit(IfStatement* node) override;
+    void visit(WhileStatement* node) override;
+    void visit(ForStatement* node) override;
+    void visit(ReturnStatement* node) override;
+    void visit(FunctionDefinition* node) override;
+    void visit(Program* node) override;
+};
+
+#endif // IR_H
@@ -0,0 +1,372 @@
+#include "loop.h"
+#include <algorithm>
+
+namespace {
+
+// 旋转时复制的循环头指令数上限
+const size_t kMaxRotatedInstrs = 12;
+
+// 每个虚拟寄存器的定义位置（SSA中唯一）
+struct DefSite {
+    int block;
+    int index;
+};
+
+std::vector<DefSite> findDefinitions(const IRFunction& func) {
+    std::vector<DefSite> defs(func.vregCount, {-1, -1});
+    for (size_t b = 0; b < func.blocks.size(); b++) {
+        const auto& instrs = func.blocks[b].instrs;
+        for (size_t i = 0; i < instrs.size(); i++) {
+            if (instrs[i].dst >= 0) {
+                defs[instrs[i].dst] = {(int)b, (int)i};
+            }
+        }
+    }
+    return defs;
+}
+
+void addBlockToLoop(Loop& loop, int block) {
+    if (block >= (int)loop.contains.size()) {
+        loop.contains.resize(block + 1, false);
+    }
+    loop.contains[block] = true;
+    loop.blocks.push_back(block);
+}
+
+// 保证循环头只有一个来自循环外、且只有唯一后继的前驱；返回前置块下标
+int ensurePreheader(IRFunction& func, Loop& loop, bool& created) {
+    int header = loop.header;
+    std::vector<int> outside;
+    for (int pred : func.blocks[header].preds) {
+        if (!loop.has(pred)) {
+            outside.push_back(pred);
+        }
+    }
+    created = false;
+    if (outside.size() == 1 && func.blocks[outside[0]].succs.size() == 1) {
+        return outside[0];
+    }
+
+    int preheader = func.blocks.size();
+    func.blocks.emplace_back("preheader");
+    func.blocks[preheader].instrs.emplace_back(IROp::Jump);
+    func.blocks[preheader].succs = {header};
+    func.blocks[preheader].preds = outside;
+    for (int pred : outside) {
+        std::replace(func.blocks[pred].succs.begin(), func.blocks[pred].succs.end(), header, preheader);
+    }
+    auto& headerPreds = func.blocks[header].preds;
+    headerPreds.erase(std::remove_if(headerPreds.begin(), headerPreds.end(),
+                                     [&](int pred) { return !loop.has(pred); }),
+                      headerPreds.end());
+    headerPreds.push_back(preheader);
+
+    // 循环头的phi：来自循环外的输入改为经由前置块流入，多个外部前驱时在前置块先合并
+    std::vector<IRInstr> preheaderPhis;
+    for (auto& instr : func.blocks[header].instrs) {
+        if (instr.op != IROp::Phi) {
+            break;
+        }
+        std::vector<PhiInput> inner, outer;
+        for (int i = 0; i < instr.b; i++) {
+            const PhiInput& input = func.phiInputs[instr.a + i];
+            (loop.has(input.block) ? inner : outer).push_back(input);
+        }
+        int value = outer.empty() ? -1 : outer[0].value;
+        if (outer.size() > 1) {
+            value = func.newVReg(func.vregNames[instr.dst]);
+            preheaderPhis.emplace_back(IROp::Phi, value, func.phiInputs.size(), outer.size());
+            func.phiInputs.insert(func.phiInputs.end(), outer.begin(), outer.end());
+        }
+        if (value >= 0) {
+            inner.push_back({preheader, value});
+        }
+        instr.a = func.phiInputs.size();
+        instr.b = inner.size();
+        func.phiInputs.insert(func.phiInputs.end(), inner.begin(), inner.end());
+    }
+    auto& instrs = func.blocks[preheader].instrs;
+    instrs.insert(instrs.begin(), preheaderPhis.begin(), preheaderPhis.end());
+    created = true;
+    return preheader;
+}
+
+// 不会产生副作用、可以提前执行的指令；safeDivisor 标记非0、非-1的常量
+bool isHoistable(const IRInstr& instr, const std::vector<bool>& safeDivisor) {
+    switch (instr.op) {
+        case IROp::Param:
+        case IROp::Phi:
+        case IROp::Call:
+        case IROp::Jump:
+        case IROp::Branch:
+        case IROp::Return:
+            return false;
+        case IROp::Div:
+        case IROp::Mod:
+            // 提前执行的除法不能引入原本不会发生的除零异常
+            return safeDivisor[instr.b];
+        default:
+            return true;
+    }
+}
+
+void hoistInvariants(IRFunction& func, const Loop& loop, int preheader) {
+    std::vector<DefSite> defs = findDefinitions(func);
+    std::vector<bool> safeDivisor(func.vregCount, false);
+    for (const auto& block : func.blocks) {
+        for (const auto& instr : block.instrs) {
+            if (instr.op == IROp::Const && instr.imm != 0 && instr.imm != -1) {
+                safeDivisor[instr.dst] = true;
+            }
+        }
+    }
+    std::vector<IRInstr> hoisted;
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (int b : loop.blocks) {
+            auto& instrs = func.blocks[b].instrs;
+            for (size_t i = 0; i < instrs.size();) {
+                const IRInstr& instr = instrs[i];
+                bool invariant = isHoistable(instr, safeDivisor);
+                forEachUse(func, instr, [&](int v) {
+                    if (loop.has(defs[v].block)) {
+                        invariant = false;
+                    }
+                });
+                if (!invariant) {
+                    i++;
+                    continue;
+                }
+                // 依赖的不变量总是先被外提，保持外提顺序即满足定义先于使用
+                defs[instr.dst] = {preheader, -1};
+                hoisted.push_back(instr);
+                instrs.erase(instrs.begin() + i);
+                changed = true;
+            }
+        }
+    }
+    auto& target = func.blocks[preheader].instrs;
+    target.insert(target.end() - 1, hoisted.begin(), hoisted.end());
+}
+
+// 基本归纳变量 i = phi(init, i ± step)，step 为循环不变量
+struct InductionVariable {
+    int phi;
+    int init;
+    int step;
+    bool decrement;
+    DefSite update;
+};
+
+void reduceInductionVariables(IRFunction& func, const Loop& loop, int preheader) {
+    int header = loop.header;
+    const auto& preds = func.blocks[header].preds;
+    if (loop.latches.size() != 1 || preds.size() != 2) {
+        return;
+    }
+    int latch = loop.latches[0];
+
+    while (true) {
+        std::vector<DefSite> defs = findDefinitions(func);
+        auto invariant = [&](int v) { return !loop.has(defs[v].block); };
+
+        std::vector<InductionVariable> ivs;
+        for (const auto& instr : func.blocks[header].instrs) {
+            if (instr.op != IROp::Phi) {
+                break;
+            }
+            int init = -1, next = -1;
+            for (int i = 0; i < instr.b; i++) {
+                const PhiInput& input = func.phiInputs[instr.a + i];
+                (input.block == preheader ? init : next) = input.value;
+            }
+            if (init < 0 || next < 0 || !loop.has(defs[next].block)) {
+                continue;
+            }
+            DefSite site = defs[next];
+            const IRInstr& update = func.blocks[site.block].instrs[site.index];
+            if (update.op == IROp::Add && update.a == instr.dst && invariant(update.b)) {
+                ivs.push_back({instr.dst, init, update.b, false, site});
+            } else if (update.op == IROp::Add && update.b == instr.dst && invariant(update.a)) {
+                ivs.push_back({instr.dst, init, update.a, false, site});
+            } else if (update.op == IROp::Sub && update.a == instr.dst && invariant(update.b)) {
+                ivs.push_back({instr.dst, init, update.b, true, site});
+            }
+        }
+        if (ivs.empty()) {
+            return;
+        }
+
+        // 找一条 j = i * k（k为循环不变量）
+        const InductionVariable* iv = nullptr;
+        DefSite target = {-1, -1};
+        int factor = -1;
+        for (int b : loop.blocks) {
+            const auto& instrs = func.blocks[b].instrs;
+            for (size_t i = 0; i < instrs.size() && !iv; i++) {
+                const IRInstr& instr = instrs[i];
+                if (instr.op != IROp::Mul) {
+                    continue;
+                }
+                for (const auto& candidate : ivs) {
+                    int other = instr.a == candidate.phi ? instr.b : instr.b == candidate.phi ? instr.a : -1;
+                    if (other >= 0 && other != candidate.phi && invariant(other)) {
+                        iv = &candidate;
+                        target = {b, (int)i};
+                        factor = other;
+                        break;
+                    }
+                }
+            }
+            if (iv) {
+                break;
+            }
+        }
+        if (!iv) {
+            return;
+        }
+
+        // 前置块中计算初值 init*k 与步长 step*k
+        DefSite stepDef = defs[iv->step];
+        const IRInstr& step = func.blocks[stepDef.block].instrs[stepDef.index];
+        bool unitStep = step.op == IROp::Const && step.imm == 1;
+        int base = func.newVReg();
+        int stride = func.newVReg();
+        auto& pre = func.blocks[preheader].instrs;
+        pre.insert(pre.end() - 1, IRInstr(IROp::Mul, base, iv->init, factor));
+        if (unitStep) {
+            pre.insert(pre.end() - 1, IRInstr(IROp::Copy, stride, factor));
+        } else {
+            pre.insert(pre.end() - 1, IRInstr(IROp::Mul, stride, iv->step, factor));
+        }
+
+        // 新归纳变量 j' = phi(base, j' ± stride)，更新紧跟在 i 的更新之后
+        int current = func.newVReg();
+        int next = func.newVReg();
+        auto& updateBlock = func.blocks[iv->update.block].instrs;
+        updateBlock.insert(updateBlock.begin() + iv->update.index + 1,
+                           IRInstr(iv->decrement ? IROp::Sub : IROp::Add, next, current, stride));
+        if (target.block == iv->update.block && target.index > iv->update.index) {
+            target.index++;
+        }
+        IRInstr& multiply = func.blocks[target.block].instrs[target.index];
+        multiply = IRInstr(IROp::Copy, multiply.dst, current);
+
+        auto& headerInstrs = func.blocks[header].instrs;
+        headerInstrs.insert(headerInstrs.begin(), IRInstr(IROp::Phi, current, func.phiInputs.size(), 2));
+        func.phiInputs.push_back({preheader, base});
+        func.phiInputs.push_back({latch, next});
+    }
+}
+
+} // namespace
+
+std::vector<Loop> findLoops(const IRFunction& func, const DominatorTree& domTree) {
+    int blockCount = func.blocks.size();
+    std::vector<Loop> loops;
+    std::vector<int> loopOf(blockCount, -1);
+    for (int b : domTree.reversePostorder()) {
+        for (int succ : func.blocks[b].succs) {
+            if (!domTree.dominates(succ, b)) {
+                continue;
+            }
+            if (loopOf[succ] < 0) {
+                loopOf[succ] = loops.size();
+                loops.emplace_back();
+                loops.back().header = succ;
+                loops.back().contains.assign(blockCount, false);
+                addBlockToLoop(loops.back(), succ);
+            }
+            loops[loopOf[succ]].latches.push_back(b);
+        }
+    }
+
+    // 从回边源块逆向遍历到循环头，途经的块都属于循环
+    for (auto& loop : loops) {
+        std::vector<int> worklist;
+        for (int latch : loop.latches) {
+            if (!loop.has(latch)) {
+                addBlockToLoop(loop, latch);
+                worklist.push_back(latch);
+            }
+        }
+        while (!worklist.empty()) {
+            int b = worklist.back();
+            worklist.pop_back();
+            for (int pred : func.blocks[b].preds) {
+                if (!loop.has(pred)) {
+                    addBlockToLoop(loop, pred);
+                    worklist.push_back(pred);
+                }
+            }
+        }
+    }
+
+    std::stable_sort(loops.begin(), loops.end(), [](const Loop& x, const Loop& y) {
+        return x.blocks.size() < y.blocks.size();
+    });
+    return loops;
+}
+
+void rotateLoops(IRFunction& func) {
+    DominatorTree domTree(func);
+    bool rotated = false;
+    for (const Loop& loop : findLoops(func, domTree)) {
+        if (loop.latches.size() != 1 || loop.latches[0] == loop.header) {
+            continue;
+        }
+        const BasicBlock& head = func.blocks[loop.header];
+        BasicBlock& tail = func.blocks[loop.latches[0]];
+        const IRInstr* branch = head.terminator();
+        // 只旋转“一个分支留在循环内、一个分支退出”的循环头
+        if (!branch || branch->op != IROp::Branch || head.succs.size() != 2 || head.instrs.size() > kMaxRotatedInstrs ||
+            loop.has(head.succs[0]) == loop.has(head.succs[1]) || tail.instrs.back().op != IROp::Jump) {
+            continue;
+        }
+        tail.instrs.pop_back();
+        tail.instrs.insert(tail.instrs.end(), head.instrs.begin(), head.instrs.end());
+        tail.succs = head.succs;
+        rotated = true;
+    }
+    if (rotated) {
+        func.rebuildCFG();
+    }
+}
+
+void optimizeLoops(IRFunction& func) {
+    DominatorTree domTree(func);
+    std::vector<Loop> loops = findLoops(func, domTree);
+    if (loops.empty()) {
+        return;
+    }
+
+    int originalCount = func.blocks.size();
+    std::vector<std::vector<int>> preheadersOf(originalCount);
+    for (size_t l = 0; l < loops.size(); l++) {
+        Loop& loop = loops[l];
+        bool created;
+        int preheader = ensurePreheader(func, loop, created);
+        if (created) {
+            preheadersOf[loop.header].push_back(preheader);
+            // 新建的前置块位于包含该循环的外层循环之内
+            int outsidePred = func.blocks[preheader].preds.empty() ? -1 : func.blocks[preheader].preds[0];
+            for (size_t k = l + 1; k < loops.size(); k++) {
+                if (outsidePred >= 0 && loops[k].has(outsidePred)) {
+                    addBlockToLoop(loops[k], preheader);
+                }
+            }
+        }
+        hoistInvariants(func, loop, preheader);
+        reduceInductionVariables(func, loop, preheader);
+    }
+
+    // 新建的前置块紧挨在各自循环头之前
+    std::vector<int> order;
+    for (int b = 0; b < originalCount; b++) {
+        order.insert(order.end(), preheadersOf[b].begin(), preheadersOf[b].end());
+        order.push_back(b);
+    }
+    func.reorderBlocks(order);
+    func.rebuildCFG();
+}
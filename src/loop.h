@@ -0,0 +1,31 @@
+#ifndef LOOP_H
+#define LOOP_H
+
+#include "ir.h"
+#include "ssa.h"
+#include <vector>
+
+// 自然循环：由回边 latch -> header 确定（header 支配 latch）
+struct Loop {
+    int header;
+    std::vector<int> latches;   // 回边的源块
+    std::vector<int> blocks;    // 循环内所有块（含header）
+    std::vector<bool> contains; // 按块下标的成员标记
+
+    bool has(int block) const { return block < (int)contains.size() && contains[block]; }
+};
+
+// 找出函数中的所有自然循环，内层循环排在前面
+std::vector<Loop> findLoops(const IRFunction& func, const DominatorTree& domTree);
+
+// 循环旋转（在构造SSA之前进行）：
+// 把循环头的条件判断复制到回边所在块的末尾，循环变为 guard + do-while 形式，
+// 每次迭代省去一次跳回循环头的无条件跳转
+void rotateLoops(IRFunction& func);
+
+// SSA形式上的循环优化：
+// 为每个循环建立前置块，把循环不变量外提到前置块（LICM），
+// 再把基本归纳变量与不变量的乘法改写为每次迭代一次加法（归纳变量强度削减）
+void optimizeLoops(IRFunction& func);
+
+#endif // LOOP_H
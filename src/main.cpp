@@ -1,18 +1,39 @@
 #include "ast.h"
 #include "codegen.h"
+#include "ir.h"
+#include "optimizer.h"
 #include "semantic.h"
+#include "output.h"
+#include "cache.h"
+#include "context.h"
+#include "parallel.h"
+#include "server.h"
 #include <iostream>
 #include <fstream>
 #include <string>
 #include <cstring>
+#include <cstdlib>
+#include <algorithm>
+#include <condition_variable>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <thread>
+#include <vector>
 
-// 外部声明
-extern int yyparse();
-extern int yylex();
-extern FILE* yyin;
-extern Program* program_root;
-extern int yylineno;
-extern char* yytext;
+// 使用的词法分析器（--lexer 选择）
+static ScannerKind scannerKind = ScannerKind::Flex;
+
+// 映射源文件并让词法分析器在其上扫描，失败时输出错误
+static bool openSource(CompileContext& context, const std::string& inputFile) {
+    if (!context.open(inputFile, scannerKind)) {
+        context.diagnostics.report(stderr, "错误: 无法打开输入文件 '%s'\n", inputFile.c_str());
+        return false;
+    }
+    return true;
+}
 
 // Token名称映射
 const char* getTokenName(int token) {
@@ -98,12 +119,10 @@ void printDFAInfo() {
     std::cout << "=========================" << std::endl;
 }
 
-// 词法分析函数
-void performLexicalAnalysis(const std::string& inputFile, bool showDFA = false) {
-    yyin = fopen(inputFile.c_str(), "r");
-    if (!yyin) {
-        std::cerr << "错误: 无法打开输入文件 '" << inputFile << "'" << std::endl;
-        return;
+// 词法分析函数；tokens非空时同时把Token存入其中，供之后的语法分析直接重放
+bool performLexicalAnalysis(CompileContext& context, const std::string& inputFile, bool showDFA = false, TokenBuffer* tokens = nullptr) {
+    if (!openSource(context, inputFile)) {
+        return false;
     }
     
     if (showDFA) {
@@ -115,19 +134,23 @@ void performLexicalAnalysis(const std::string& inputFile, bool showDFA = false)
     std::cout << "----\t--------\t\t----\t\t-------" << std::endl;
     
     int token;
-    yylineno = 1;
     int tokenCount = 0;
     int errorCount = 0;
     
-    while ((token = yylex()) != 0) {
+    while ((token = context.lexer.next()) != 0) {
+        // 词素以(偏移, 长度)引用映射的源文件，不单独复制
+        const TokenView& view = context.lexer.token();
+        if (tokens) {
+            context.lexer.record(*tokens);
+        }
         if (token == 280) { // ERROR_TOKEN
             errorCount++;
-            std::cout << yylineno << "\t" << getTokenName(token) << "\t\t" 
-                      << yytext << "\t\t" << token << " (词法错误)" << std::endl;
+            std::cout << view.line << "\t" << getTokenName(token) << "\t\t" 
+                      << context.source->text(view) << "\t\t" << token << " (词法错误)" << std::endl;
             break;
         } else {
-            std::cout << yylineno << "\t" << getTokenName(token) << "\t\t" 
-                      << yytext << "\t\t" << token << std::endl;
+            std::cout << view.line << "\t" << getTokenName(token) << "\t\t" 
+                      << context.source->text(view) << "\t\t" << token << std::endl;
             tokenCount++;
         }
     }
@@ -141,35 +164,29 @@ void performLexicalAnalysis(const std::string& inputFile, bool showDFA = false)
         std::cout << "✓ 词法分析成功" << std::endl;
     }
     std::cout << "=============================" << std::endl;
-    fclose(yyin);
+    context.lexer.end();
+    return true;
 }
 
-// 语法分析函数
-bool performSyntaxAnalysis(const std::string& inputFile, bool printAST = false) {
-    yyin = fopen(inputFile.c_str(), "r");
-    if (!yyin) {
-        std::cerr << "错误: 无法打开输入文件 '" << inputFile << "'" << std::endl;
+// 语法分析函数；tokens非空时重放词法分析阶段已得到的Token，不再重新扫描文件
+bool performSyntaxAnalysis(CompileContext& context, const std::string& inputFile, bool printAST = false, const TokenBuffer* tokens = nullptr) {
+    if (tokens) {
+        context.lexer.replay(*tokens);
+    } else if (!openSource(context, inputFile)) {
         return false;
     }
     
     std::cout << "\n=== 语法分析过程 ===" << std::endl;
     std::cout << "正在进行语法分析..." << std::endl;
     
-    // 初始化全局变量
-    program_root = nullptr;
-    yylineno = 1;
-    
     // 执行语法分析
-    int parseResult = yyparse();
-    fclose(yyin);
-    
-    if (parseResult != 0) {
+    if (!context.parse()) {
         std::cout << "\n语法分析失败！程序包含语法错误，无法继续进行语义分析。" << std::endl;
         std::cout << "请修复上述语法错误后重新编译。" << std::endl;
         return false;
     }
     
-    if (!program_root) {
+    if (!context.program) {
         std::cout << "错误: 未生成语法树" << std::endl;
         return false;
     }
@@ -179,7 +196,7 @@ bool performSyntaxAnalysis(const std::string& inputFile, bool printAST = false)
     // 打印AST
     if (printAST) {
         std::cout << "\n=== 抽象语法树（AST） ===" << std::endl;
-        program_root->print();
+        context.program->print();
         std::cout << "===========================" << std::endl;
     }
     
@@ -187,44 +204,286 @@ bool performSyntaxAnalysis(const std::string& inputFile, bool printAST = false)
 }
 
 // 语法分析函数
-bool performSyntaxAnalysisQuiet(const std::string& inputFile) {
-    yyin = fopen(inputFile.c_str(), "r");
-    if (!yyin) {
-        std::cerr << "错误: 无法打开输入文件 '" << inputFile << "'" << std::endl;
+bool performSyntaxAnalysisQuiet(CompileContext& context, const std::string& inputFile) {
+    // 调用者已打开源文件（如为计算缓存键）时直接分析
+    if (!context.source && !openSource(context, inputFile)) {
         return false;
     }
     
-    // 初始化全局变量
-    program_root = nullptr;
-    yylineno = 1;
+    // 执行语法分析
+    if (!context.parse()) {
+        context.diagnostics.report(stderr, "语法分析失败！程序包含语法错误，无法继续编译。\n");
+        return false;
+    }
+    
+    if (!context.program) {
+        context.diagnostics.report(stderr, "错误: 未生成语法树\n");
+        return false;
+    }
+    
+    return true;
+}
+
+// 编译选项（缺省模式和批量模式共用）
+struct CompileOptions {
+    bool optimize = true;
+    bool printStats = false;
+    unsigned jobs = 1;              // 并行生成各函数的线程数
+    CompileCache* cache = nullptr;  // 编译缓存，为空时不使用
+};
+
+// 缓存键中的选项部分：只包含影响输出内容的选项
+static std::string cacheOptions(bool optimize) {
+    return optimize ? "-O" : "-O0";
+}
+
+// 窥孔优化统计（--stats的输出内容，同时存入缓存供命中时输出）
+static std::string peepholeReport(const PeepholeOptimizer& peephole) {
+    std::string text = "窥孔优化改写次数:\n";
+    for (size_t i = 0; i < peephole.ruleCount(); i++) {
+        text += std::string("  ") + peephole.ruleName(i) + ": " + std::to_string(peephole.rewriteCount(i)) + "\n";
+    }
+    text += "  合计: " + std::to_string(peephole.totalRewrites()) + "\n";
+    return text;
+}
+
+// 把汇编文本写到outputFile；为空或"-"时输出到标准输出
+static bool writeAssembly(Diagnostics& diagnostics, const std::string& outputFile, const std::string& text) {
+    std::unique_ptr<FileSink> sink;
+    if (outputFile.empty() || outputFile == "-") {
+        sink.reset(new FileSink(stdout));
+    } else {
+        sink = FileSink::open(outputFile);
+        if (!sink) {
+            diagnostics.report(stderr, "错误: 无法打开输出文件 '%s'\n", outputFile.c_str());
+            return false;
+        }
+    }
+    sink->write(text);
+    if (!sink->flush()) {
+        diagnostics.report(stderr, "错误: 写入汇编代码失败\n");
+        return false;
+    }
+    return true;
+}
+
+// 编译一个文件并写出汇编（缺省模式和批量模式共用）；outputFile为空或"-"时输出到标准输出。
+// 所有信息经context.diagnostics输出，quiet时省略进度提示。
+// 使用缓存时先按源文件内容查找：命中则直接写出缓存的汇编，跳过词法、语法、语义分析和代码生成；
+// 未命中则正常编译（各函数按指纹增量生成），并把汇编、优化后的IR和窥孔统计存入缓存
+bool compileFile(CompileContext& context, const std::string& inputFile, const std::string& outputFile,
+                 const CompileOptions& options, bool quiet = false) {
+    Diagnostics& diagnostics = context.diagnostics;
+    
+    CacheKey key = {0, 0};
+    if (options.cache) {
+        if (!openSource(context, inputFile)) {
+            return false;
+        }
+        key = CompileCache::key(context.source->data(), context.source->size(), cacheOptions(options.optimize));
+        std::string assembly;
+        std::string stats;
+        if (options.cache->lookup(key, "asm", assembly) &&
+            (!options.printStats || options.cache->lookup(key, "stats", stats))) {
+            if (!writeAssembly(diagnostics, outputFile, assembly)) {
+                return false;
+            }
+            if (!quiet) {
+                diagnostics.report(stderr, "汇编代码生成成功！（命中编译缓存）\n");
+            }
+            if (options.printStats) {
+                diagnostics.report(stderr, "%s", stats.c_str());
+            }
+            return true;
+        }
+    }
     
     // 执行语法分析
-    int parseResult = yyparse();
-    fclose(yyin);
+    if (!performSyntaxAnalysisQuiet(context, inputFile)) {
+        return false;
+    }
     
-    if (parseResult != 0) {
-        std::cerr << "语法分析失败！程序包含语法错误，无法继续编译。" << std::endl;
+    // 执行语义分析
+    SemanticAnalyzer analyzer;
+    analyzer.enableFolding(options.optimize);
+    if (!analyzer.analyze(context.program, true)) {
+        diagnostics.report(stderr, "语义分析失败，停止编译。\n");
+        diagnostics.report(stderr, "请使用 --semantic 选项查看详细的语义错误信息。\n");
         return false;
     }
     
-    if (!program_root) {
-        std::cerr << "错误: 未生成语法树" << std::endl;
+    // 生成汇编代码
+    if (!quiet) {
+        diagnostics.report(stderr, "正在生成汇编代码...\n");
+    }
+    
+    // 汇编先生成到内存中（各函数本就分别缓冲后按顺序拼接），再写出到目标文件。
+    // 使用缓存时按函数增量生成：整个文件未命中时，未改动的函数仍复用各自缓存的汇编
+    BufferSink buffer;
+    CodeGenerator codeGen(buffer, options.optimize, options.jobs);
+    size_t reused = 0;
+    std::string irText;
+    if (options.cache) {
+        reused = codeGen.generateAssembly(context.program, *options.cache, cacheOptions(options.optimize), &irText);
+    } else {
+        codeGen.generateAssembly(context.program);
+    }
+    if (!writeAssembly(diagnostics, outputFile, buffer.str())) {
         return false;
     }
     
+    // 汇编连同中间结果（优化后的IR、窥孔统计）存入缓存
+    if (options.cache) {
+        options.cache->store(key, {{"asm", buffer.str()}, {"ir", irText}, {"stats", peepholeReport(codeGen.getPeephole())}});
+    }
+    
+    if (!quiet) {
+        if (reused > 0) {
+            diagnostics.report(stderr, "汇编代码生成成功！（%zu 个函数复用了编译缓存）\n", reused);
+        } else {
+            diagnostics.report(stderr, "汇编代码生成成功！\n");
+        }
+    }
+    
+    if (options.printStats) {
+        diagnostics.report(stderr, "%s", peepholeReport(codeGen.getPeephole()).c_str());
+    }
+    
+    return true;
+}
+
+// 批量模式下输入文件对应的汇编文件：把扩展名.c换成.s，其他情况追加.s
+static std::string assemblyPath(const std::string& inputFile) {
+    size_t slash = inputFile.find_last_of("/\\");
+    size_t dot = inputFile.rfind('.');
+    if (dot != std::string::npos && (slash == std::string::npos || dot > slash) && inputFile.compare(dot, std::string::npos, ".c") == 0) {
+        return inputFile.substr(0, dot) + ".s";
+    }
+    return inputFile + ".s";
+}
+
+// 批量编译：每个输入文件各用一个编译上下文，由jobs个线程并行完成词法、语法、语义分析和代码生成，
+// 汇编写入各自的.s文件。诊断信息先缓存，按输入顺序逐个输出，并给出每个文件的结果，
+// 因此输出与线程调度无关。任一文件失败时返回1
+int compileBatch(const std::vector<std::string>& inputFiles, unsigned jobs, const CompileOptions& options) {
+    size_t count = inputFiles.size();
+    std::vector<std::string> outputFiles;
+    std::set<std::string> seen;
+    for (const std::string& inputFile : inputFiles) {
+        outputFiles.push_back(assemblyPath(inputFile));
+        if (!seen.insert(outputFiles.back()).second) {
+            std::cerr << "错误: 多个输入文件对应同一个输出文件 '" << outputFiles.back() << "'" << std::endl;
+            return 1;
+        }
+    }
+    
+    std::vector<std::unique_ptr<Diagnostics>> diagnostics;
+    for (size_t i = 0; i < count; i++) {
+        diagnostics.emplace_back(new Diagnostics(true));
+    }
+    std::vector<char> succeeded(count, 0);
+    std::vector<char> finished(count, 0);
+    std::mutex mutex;
+    std::condition_variable finishedChanged;
+    
+    // 文件之间已经并行，单个文件内的函数不再拆分到多个线程
+    unsigned threadCount = static_cast<unsigned>(std::min<size_t>(jobs, count));
+    CompileOptions fileOptions = options;
+    fileOptions.jobs = 1;
+    std::thread runner([&]() {
+        parallelFor(count, threadCount, [&](size_t i) {
+            bool ok;
+            {
+                CompileContext context(*diagnostics[i]);
+                ok = compileFile(context, inputFiles[i], outputFiles[i], fileOptions, true);
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            succeeded[i] = ok;
+            finished[i] = 1;
+            finishedChanged.notify_all();
+        });
+    });
+    
+    // 按输入顺序输出各文件的结果，前面的文件完成后即可输出，不必等待全部结束
+    size_t failures = 0;
+    for (size_t i = 0; i < count; i++) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            finishedChanged.wait(lock, [&]() { return finished[i] != 0; });
+        }
+        diagnostics[i]->flush();
+        if (succeeded[i]) {
+            std::cerr << "✓ " << inputFiles[i] << " -> " << outputFiles[i] << std::endl;
+        } else {
+            std::cerr << "✗ " << inputFiles[i] << ": 编译失败" << std::endl;
+            failures++;
+        }
+        diagnostics[i].reset();
+    }
+    runner.join();
+    
+    std::cerr << "批量编译完成: 共 " << count << " 个文件，成功 " << (count - failures)
+              << " 个，失败 " << failures << " 个（" << threadCount << " 个线程）" << std::endl;
+    return failures == 0 ? 0 : 1;
+}
+
+// 按目录取得编译缓存：同一进程内的各条命令（服务模式下的各个请求）共用同一实例，
+// 目录大小的估计等状态随之保留。目录按绝对路径区分，失败时返回nullptr
+static CompileCache* openCache(const std::string& cacheDir, uint64_t megabytes) {
+    static std::map<std::string, std::unique_ptr<CompileCache>> caches;
+    std::error_code error;
+    std::string directory = std::filesystem::absolute(cacheDir, error).lexically_normal().string();
+    if (error) {
+        return nullptr;
+    }
+    std::unique_ptr<CompileCache>& cache = caches[directory + '\0' + std::to_string(megabytes)];
+    if (!cache) {
+        cache.reset(new CompileCache(directory, megabytes << 20));
+    }
+    // 目录可能在两次请求之间被删除，每次都确认一下
+    return cache->prepare() ? cache.get() : nullptr;
+}
+
+// 展开响应文件：参数 @文件 替换为该文件中以空白分隔的各项（可嵌套），其他参数原样加入
+static bool expandArgument(const std::string& arg, std::vector<std::string>& args, int depth = 0) {
+    if (arg.size() < 2 || arg[0] != '@') {
+        args.push_back(arg);
+        return true;
+    }
+    std::ifstream file(arg.substr(1));
+    if (!file || depth >= 16) {
+        std::cerr << "错误: 无法读取响应文件 '" << arg.substr(1) << "'" << std::endl;
+        return false;
+    }
+    std::string item;
+    while (file >> item) {
+        if (!expandArgument(item, args, depth + 1)) {
+            return false;
+        }
+    }
     return true;
 }
 
 void printUsage(const char* progName) {
-    std::cout << "用法: " << progName << " [选项] <输入文件>" << std::endl;
+    std::cout << "用法: " << progName << " [选项] <输入文件>..." << std::endl;
     std::cout << "选项:" << std::endl;
-    std::cout << "  -o <输出文件>  指定输出文件名" << std::endl;
+    std::cout << "  -o <输出文件>  指定输出文件名（缺省输出到标准输出）" << std::endl;
+    std::cout << "  -O0            关闭优化（AST常量折叠与强度削减、SSA常量传播、复制传播、死代码删除、窥孔优化）" << std::endl;
+    std::cout << "  --stats        生成汇编后输出各窥孔规则的改写次数" << std::endl;
+    std::cout << "  --lexer <实现> 选择词法分析器：flex（缺省）或 simd（手写SIMD扫描器）" << std::endl;
+    std::cout << "  -j <线程数>    并行编译的线程数，缺省为CPU核数（多个输入文件时按文件并行，否则按函数并行生成代码）" << std::endl;
+    std::cout << "  @<文件>        从响应文件读取参数（以空白分隔）" << std::endl;
+    std::cout << "  --cache-dir <目录>  启用编译缓存：源文件内容与选项相同时直接取出之前生成的汇编/IR" << std::endl;
+    std::cout << "  --cache-size <MB>   缓存目录大小上限，超出时淘汰最久未使用的条目（缺省256）" << std::endl;
+    std::cout << "  --server <套接字>   作为编译服务常驻，在该Unix域套接字上接受请求（缓存等状态在请求之间保留）" << std::endl;
+    std::cout << "  --client <套接字>   把其余命令行交给该套接字上的编译服务执行，服务不可用时在本地编译" << std::endl;
     std::cout << "  -h, --help     显示帮助信息" << std::endl;
     std::cout << "  -v, --version  显示版本信息" << std::endl;
     std::cout << "  --tokens       仅进行词法分析，输出Token序列" << std::endl;
     std::cout << "  --tokens-dfa   词法分析 + DFA信息" << std::endl;
     std::cout << "  --ast          仅进行语法分析，输出抽象语法树" << std::endl;
     std::cout << "  --semantic     进行语义分析，输出语义信息" << std::endl;
+    std::cout << "  --ir           输出（优化后的）中间表示（三地址码与基本块）" << std::endl;
     std::cout << "  --all-phases   展示所有分析阶段的成果" << std::endl;
     std::cout << std::endl;
     std::cout << "示例:" << std::endl;
@@ -232,7 +491,11 @@ void printUsage(const char* progName) {
     std::cout << "  " << progName << " test.c --tokens" << std::endl;
     std::cout << "  " << progName << " test.c --ast" << std::endl;
     std::cout << "  " << progName << " test.c --semantic" << std::endl;
+    std::cout << "  " << progName << " test.c --ir" << std::endl;
     std::cout << "  " << progName << " test.c --all-phases" << std::endl;
+    std::cout << "  " << progName << " -j 8 a.c b.c c.c      （分别生成 a.s b.s c.s）" << std::endl;
+    std::cout << "  " << progName << " --server /tmp/cc.sock &" << std::endl;
+    std::cout << "  " << progName << " --client /tmp/cc.sock test.c -o test.s" << std::endl;
 }
 
 void printVersion() {
@@ -240,78 +503,153 @@ void printVersion() {
     std::cout << "支持基本C语言语法，生成x86汇编代码" << std::endl;
 }
 
-int main(int argc, char* argv[]) {
-    std::string inputFile;
+// 执行一条已展开响应文件的命令行（args[0]为程序名），返回退出码。
+// 本地运行和服务模式下的每个请求都经由这里，因此不能依赖上一条命令留下的选项状态
+static int runCommand(const std::vector<std::string>& args) {
+    const char* progName = args[0].c_str();
+    std::vector<std::string> inputFiles;
     std::string outputFile;
     bool tokensOnly = false;
     bool tokensDFA = false;
     bool astOnly = false;
     bool semanticOnly = false;
+    bool irOnly = false;
     bool allPhases = false;
+    bool optimize = true;
+    bool printStats = false;
+    unsigned jobs = std::max(1u, std::thread::hardware_concurrency());
+    std::string cacheDir;
+    uint64_t cacheMegabytes = 256;
+    scannerKind = ScannerKind::Flex;
     
     // 解析命令行参数
-    for (int i = 1; i < argc; i++) {
-        if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0) {
-            printUsage(argv[0]);
+    for (size_t i = 1; i < args.size(); i++) {
+        if (args[i] == "-h" || args[i] == "--help") {
+            printUsage(progName);
             return 0;
-        } else if (strcmp(argv[i], "-v") == 0 || strcmp(argv[i], "--version") == 0) {
+        } else if (args[i] == "-v" || args[i] == "--version") {
             printVersion();
             return 0;
-        } else if (strcmp(argv[i], "--tokens") == 0) {
+        } else if (args[i] == "--tokens") {
             tokensOnly = true;
-        } else if (strcmp(argv[i], "--tokens-dfa") == 0) {
+        } else if (args[i] == "--tokens-dfa") {
             tokensDFA = true;
-        } else if (strcmp(argv[i], "--ast") == 0) {
+        } else if (args[i] == "--ast") {
             astOnly = true;
-        } else if (strcmp(argv[i], "--semantic") == 0) {
+        } else if (args[i] == "--semantic") {
             semanticOnly = true;
-        } else if (strcmp(argv[i], "--all-phases") == 0) {
+        } else if (args[i] == "--ir") {
+            irOnly = true;
+        } else if (args[i] == "--all-phases") {
             allPhases = true;
-        } else if (strcmp(argv[i], "-o") == 0) {
-            if (i + 1 < argc) {
-                outputFile = argv[++i];
+        } else if (args[i] == "-O0") {
+            optimize = false;
+        } else if (args[i] == "--stats") {
+            printStats = true;
+        } else if (args[i] == "--lexer") {
+            if (i + 1 < args.size() && args[i + 1] == "flex") {
+                scannerKind = ScannerKind::Flex;
+            } else if (i + 1 < args.size() && args[i + 1] == "simd") {
+                scannerKind = ScannerKind::Simd;
+            } else {
+                std::cerr << "错误: --lexer 选项需要指定 flex 或 simd" << std::endl;
+                return 1;
+            }
+            i++;
+        } else if (args[i] == "-o") {
+            if (i + 1 < args.size()) {
+                outputFile = args[++i];
             } else {
                 std::cerr << "错误: -o 选项需要指定输出文件名" << std::endl;
                 return 1;
             }
-        } else if (argv[i][0] != '-') {
-            if (inputFile.empty()) {
-                inputFile = argv[i];
+        } else if (args[i] == "--cache-dir") {
+            if (i + 1 < args.size()) {
+                cacheDir = args[++i];
+            } else {
+                std::cerr << "错误: --cache-dir 选项需要指定目录" << std::endl;
+                return 1;
+            }
+        } else if (args[i] == "--cache-size") {
+            if (i + 1 < args.size() && atoi(args[i + 1].c_str()) > 0) {
+                cacheMegabytes = static_cast<uint64_t>(atoi(args[++i].c_str()));
             } else {
-                std::cerr << "错误: 只能指定一个输入文件" << std::endl;
+                std::cerr << "错误: --cache-size 选项需要指定正整数（MB）" << std::endl;
                 return 1;
             }
+        } else if (args[i] == "-j") {
+            if (i + 1 < args.size() && atoi(args[i + 1].c_str()) > 0) {
+                jobs = static_cast<unsigned>(atoi(args[++i].c_str()));
+            } else {
+                std::cerr << "错误: -j 选项需要指定正整数线程数" << std::endl;
+                return 1;
+            }
+        } else if (args[i][0] != '-') {
+            inputFiles.push_back(args[i]);
         } else {
-            std::cerr << "错误: 未知选项 " << argv[i] << std::endl;
-            printUsage(argv[0]);
+            std::cerr << "错误: 未知选项 " << args[i] << std::endl;
+            printUsage(progName);
             return 1;
         }
     }
     
     // 检查输入文件
-    if (inputFile.empty()) {
+    if (inputFiles.empty()) {
         std::cerr << "错误: 请指定输入文件" << std::endl;
-        printUsage(argv[0]);
+        printUsage(progName);
         return 1;
     }
     
+    // 编译缓存（--cache-dir 指定目录时启用）
+    CompileCache* cache = nullptr;
+    if (!cacheDir.empty()) {
+        cache = openCache(cacheDir, cacheMegabytes);
+        if (!cache) {
+            std::cerr << "错误: 无法创建缓存目录 '" << cacheDir << "'" << std::endl;
+            return 1;
+        }
+    }
+    
+    CompileOptions options;
+    options.optimize = optimize;
+    options.printStats = printStats;
+    options.jobs = jobs;
+    options.cache = cache;
+    
+    // 多个输入文件：批量编译，各自输出到同名的.s文件
+    if (inputFiles.size() > 1) {
+        if (tokensOnly || tokensDFA || astOnly || semanticOnly || irOnly || allPhases) {
+            std::cerr << "错误: 分析选项只能用于单个输入文件" << std::endl;
+            return 1;
+        }
+        if (!outputFile.empty()) {
+            std::cerr << "错误: 多个输入文件时不能使用 -o，汇编输出到各自的 .s 文件" << std::endl;
+            return 1;
+        }
+        return compileBatch(inputFiles, jobs, options);
+    }
+    const std::string& inputFile = inputFiles[0];
+    
+    // 本次编译的上下文（源文件、词法分析器、语法树），随本条命令返回一起释放
+    Diagnostics diagnostics;
+    CompileContext context(diagnostics);
+    
     // 处理各种分析模式
     if (tokensOnly) {
         // 仅词法分析
-        performLexicalAnalysis(inputFile, false);
+        performLexicalAnalysis(context, inputFile, false);
         return 0;
     }
     
     if (tokensDFA) {
         // 词法分析 + DFA信息
-        performLexicalAnalysis(inputFile, true);
+        performLexicalAnalysis(context, inputFile, true);
         return 0;
     }
     
     if (astOnly) {
         // 仅语法分析
-        if (performSyntaxAnalysis(inputFile, true)) {
-            delete program_root;
+        if (performSyntaxAnalysis(context, inputFile, true)) {
             return 0;
         } else {
             return 1;
@@ -320,31 +658,67 @@ int main(int argc, char* argv[]) {
     
     if (semanticOnly) {
         // 仅语义分析
-        if (performSyntaxAnalysis(inputFile, false)) {
+        if (performSyntaxAnalysis(context, inputFile, false)) {
             SemanticAnalyzer analyzer;
-            bool success = analyzer.analyze(program_root);
+            bool success = analyzer.analyze(context.program);
             
             // 输出带语义信息的语法树
-            analyzer.printSemanticTree(program_root);
+            analyzer.printSemanticTree(context.program);
             
-            delete program_root;
             return success ? 0 : 1;
         } else {
             return 1;
         }
     }
     
+    if (irOnly) {
+        // 输出中间表示；使用缓存时可直接取出之前编译同一内容时保存的IR。
+        // 未命中时不写入：条目总是由完整编译整体写入，不单独存放IR
+        if (cache) {
+            if (!openSource(context, inputFile)) {
+                return 1;
+            }
+            CacheKey key = CompileCache::key(context.source->data(), context.source->size(), cacheOptions(optimize));
+            std::string text;
+            if (cache->lookup(key, "ir", text)) {
+                std::cout << text;
+                return 0;
+            }
+        }
+        if (!performSyntaxAnalysisQuiet(context, inputFile)) {
+            return 1;
+        }
+        SemanticAnalyzer analyzer;
+        analyzer.enableFolding(optimize);
+        if (!analyzer.analyze(context.program, true)) {
+            std::cerr << "语义分析失败，无法生成中间表示。" << std::endl;
+            return 1;
+        }
+        IRBuilder builder;
+        IRProgram ir = builder.build(context.program);
+        if (optimize) {
+            Optimizer().run(ir);
+        }
+        std::ostringstream text;
+        ir.print(text);
+        std::cout << text.str();
+        return 0;
+    }
+    
     if (allPhases) {
         // 展示所有分析阶段
         std::cout << "=== 编译器各阶段分析成果展示 ===" << std::endl;
         
-        // 1. 词法分析
+        // 1. 词法分析（只扫描一次，Token留给语法分析重放）
         std::cout << "\n第一阶段：词法分析" << std::endl;
-        performLexicalAnalysis(inputFile, true);
+        TokenBuffer tokens;
+        if (!performLexicalAnalysis(context, inputFile, true, &tokens)) {
+            return 1;
+        }
         
         // 2. 语法分析
         std::cout << "\n第二阶段：语法分析" << std::endl;
-        if (!performSyntaxAnalysis(inputFile, true)) {
+        if (!performSyntaxAnalysis(context, inputFile, true, &tokens)) {
             std::cout << "\n=== 编译过程终止 ===" << std::endl;
             std::cout << "✗ 由于语法错误，编译过程无法继续。" << std::endl;
             std::cout << "请修复语法错误后重新编译。" << std::endl;
@@ -354,10 +728,10 @@ int main(int argc, char* argv[]) {
         // 3. 语义分析
         std::cout << "\n第三阶段：语义分析" << std::endl;
         SemanticAnalyzer analyzer;
-        bool semanticSuccess = analyzer.analyze(program_root);
+        bool semanticSuccess = analyzer.analyze(context.program);
         
         // 输出带语义信息的语法树
-        analyzer.printSemanticTree(program_root);
+        analyzer.printSemanticTree(context.program);
         
         std::cout << "\n=== 所有分析阶段完成 ===" << std::endl;
         if (semanticSuccess) {
@@ -366,46 +740,42 @@ int main(int argc, char* argv[]) {
             std::cout << "✗ 语义分析阶段发现错误，请修复后重新编译。" << std::endl;
         }
         
-        delete program_root;
         return semanticSuccess ? 0 : 1;
     }
     
     // 默认编译模式（生成汇编代码）
-    // 设置默认输出文件名
-    if (outputFile.empty()) {
-        size_t pos = inputFile.find_last_of('.');
-        if (pos != std::string::npos) {
-            outputFile = inputFile.substr(0, pos) + ".s";
-        } else {
-            outputFile = inputFile + ".s";
+    return compileFile(context, inputFile, outputFile, options) ? 0 : 1;
+}
+
+int main(int argc, char* argv[]) {
+    // 先展开响应文件（客户端模式下在本地展开，服务端只收到完整的参数）
+    std::vector<std::string> args(1, argv[0]);
+    for (int i = 1; i < argc; i++) {
+        if (!expandArgument(argv[i], args)) {
+            return 1;
         }
     }
     
-    // 执行语法分析
-    if (!performSyntaxAnalysisQuiet(inputFile)) {
-        return 1;
-    }
-    
-    // 执行语义分析
-    SemanticAnalyzer analyzer;
-    if (!analyzer.analyze(program_root, true)) {
-        std::cerr << "语义分析失败，停止编译。" << std::endl;
-        std::cerr << "请使用 --semantic 选项查看详细的语义错误信息。" << std::endl;
-        delete program_root;
-        return 1;
+    if (args.size() > 1 && (args[1] == "--server" || args[1] == "--client")) {
+        if (args.size() < 3) {
+            std::cerr << "错误: " << args[1] << " 选项需要指定套接字路径" << std::endl;
+            return 1;
+        }
+        const std::string socketPath = args[2];
+        if (args[1] == "--server") {
+            if (args.size() > 3) {
+                std::cerr << "错误: --server 不接受其他参数，编译选项随各个请求给出" << std::endl;
+                return 1;
+            }
+            return runServer(socketPath, runCommand);
+        }
+        // 客户端：去掉 --client <套接字> 后原样转发
+        args.erase(args.begin() + 1, args.begin() + 3);
+        int status = runClient(socketPath, args);
+        if (status >= 0) {
+            return status;
+        }
+        std::cerr << "警告: 无法连接编译服务 '" << socketPath << "'，改为本地编译" << std::endl;
     }
-    
-    // 生成汇编代码
-    std::cerr << "正在生成汇编代码..." << std::endl;
-    
-    // 直接输出到标准输出，不使用文件
-    CodeGenerator codeGen(std::cout);
-    codeGen.generateAssembly(program_root);
-    
-    std::cerr << "汇编代码生成成功！" << std::endl;
-    
-    // 清理内存
-    delete program_root;
-    
-    return 0;
-} 
\ No newline at end of file
+    return runCommand(args);
+}
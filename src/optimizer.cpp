@@ -0,0 +1,405 @@
+#include "optimizer.h"
+#include "loop.h"
+#include "ssa.h"
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+
+namespace {
+
+// SCCP格值：未定义 ⊑ 常量 ⊑ 非常量
+enum LatticeState { Undefined, Constant, Overdefined };
+
+struct LatticeValue {
+    LatticeState state;
+    int value;
+
+    bool operator==(const LatticeValue& other) const {
+        return state == other.state && (state != Constant || value == other.value);
+    }
+};
+
+LatticeValue meet(const LatticeValue& x, const LatticeValue& y) {
+    if (x.state == Undefined) {
+        return y;
+    }
+    if (y.state == Undefined) {
+        return x;
+    }
+    if (x.state == Constant && y.state == Constant && x.value == y.value) {
+        return x;
+    }
+    return {Overdefined, 0};
+}
+
+// 按int语义（32位回绕）折叠二元运算；除零等无法折叠时返回false
+bool foldBinary(IROp op, int a, int b, int& result) {
+    int64_t x = a, y = b, r;
+    switch (op) {
+        case IROp::Add: r = x + y; break;
+        case IROp::Sub: r = x - y; break;
+        case IROp::Mul: r = x * y; break;
+        case IROp::Div:
+        case IROp::Mod:
+            if (y == 0 || (x == INT_MIN && y == -1)) {
+                return false;
+            }
+            r = op == IROp::Div ? x / y : x % y;
+            break;
+        case IROp::And: r = x & y; break;
+        case IROp::Or: r = x | y; break;
+        case IROp::Shl:
+        case IROp::Sar:
+            if (y < 0 || y > 31) {
+                return false;
+            }
+            r = op == IROp::Shl ? int64_t(uint32_t(x) << y) : x >> y;
+            break;
+        case IROp::CmpEq: r = x == y; break;
+        case IROp::CmpNe: r = x != y; break;
+        case IROp::CmpLt: r = x < y; break;
+        case IROp::CmpGt: r = x > y; break;
+        case IROp::CmpLe: r = x <= y; break;
+        case IROp::CmpGe: r = x >= y; break;
+        default: return false;
+    }
+    result = static_cast<int32_t>(static_cast<uint32_t>(r));
+    return true;
+}
+
+} // namespace
+
+void Optimizer::run(IRProgram& program) {
+    for (auto& func : program.functions) {
+        run(func);
+    }
+}
+
+void Optimizer::run(IRFunction& func) {
+    function = &func;
+    rotateLoops(func);
+    constructSSA(func);
+    propagateConstants();
+    mergeBlocks();
+    propagateCopies();
+    optimizeLoops(func);
+    propagateConstants();
+    propagateCopies();
+    eliminateDeadCode();
+    destructSSA(func);
+    func.compactVRegs();
+    function = nullptr;
+}
+
+void Optimizer::propagateConstants() {
+    IRFunction& func = *function;
+    int blockCount = func.blocks.size();
+
+    std::vector<LatticeValue> lattice(func.vregCount, {Undefined, 0});
+    std::vector<std::vector<std::pair<int, int>>> uses(func.vregCount);  // (块, 指令下标)
+    std::vector<std::vector<char>> edgeExecutable(blockCount);
+    std::vector<bool> blockVisited(blockCount, false);
+    for (int b = 0; b < blockCount; b++) {
+        edgeExecutable[b].assign(func.blocks[b].succs.size(), 0);
+        const auto& instrs = func.blocks[b].instrs;
+        for (size_t i = 0; i < instrs.size(); i++) {
+            forEachUse(func, instrs[i], [&](int v) { uses[v].emplace_back(b, i); });
+        }
+    }
+
+    std::vector<int> flowWork;  // 新变为可执行的边的目标块
+    std::vector<int> ssaWork;   // 格值下降的虚拟寄存器
+
+    auto markEdge = [&](int from, int to) {
+        const auto& succs = func.blocks[from].succs;
+        for (size_t k = 0; k < succs.size(); k++) {
+            if (succs[k] == to && !edgeExecutable[from][k]) {
+                edgeExecutable[from][k] = 1;
+                flowWork.push_back(to);
+            }
+        }
+    };
+    auto edgeIsExecutable = [&](int from, int to) {
+        const auto& succs = func.blocks[from].succs;
+        for (size_t k = 0; k < succs.size(); k++) {
+            if (succs[k] == to) {
+                return edgeExecutable[from][k] != 0;
+            }
+        }
+        return false;
+    };
+
+    auto evaluate = [&](int b, int i) {
+        const IRInstr& instr = func.blocks[b].instrs[i];
+        const auto& succs = func.blocks[b].succs;
+        if (instr.op == IROp::Jump) {
+            markEdge(b, succs[0]);
+            return;
+        }
+        if (instr.op == IROp::Branch) {
+            const LatticeValue& cond = lattice[instr.a];
+            if (cond.state == Constant) {
+                markEdge(b, succs[cond.value != 0 ? 0 : 1]);
+            } else if (cond.state == Overdefined) {
+                markEdge(b, succs[0]);
+                markEdge(b, succs[1]);
+            }
+            return;
+        }
+        if (instr.dst < 0) {
+            return;
+        }
+
+        LatticeValue result = {Overdefined, 0};
+        switch (instr.op) {
+            case IROp::Const:
+                result = {Constant, instr.imm};
+                break;
+            case IROp::Copy:
+                result = lattice[instr.a];
+                break;
+            case IROp::Param:
+            case IROp::Call:
+                break;
+            case IROp::Phi:
+                result = {Undefined, 0};
+                for (int k = 0; k < instr.b; k++) {
+                    const PhiInput& input = func.phiInputs[instr.a + k];
+                    if (edgeIsExecutable(input.block, b)) {
+                        result = meet(result, lattice[input.value]);
+                    }
+                }
+                break;
+            case IROp::Neg:
+            case IROp::Not: {
+                const LatticeValue& operand = lattice[instr.a];
+                result = operand;
+                if (operand.state == Constant) {
+                    result.value = instr.op == IROp::Neg
+                        ? static_cast<int32_t>(0u - static_cast<uint32_t>(operand.value))
+                        : operand.value == 0;
+                }
+                break;
+            }
+            default: {
+                const LatticeValue& x = lattice[instr.a];
+                const LatticeValue& y = lattice[instr.b];
+                // 一侧为常量时可能直接决定结果（x*0、x&0、x|1）
+                auto absorbs = [&](const LatticeValue& v) {
+                    return v.state == Constant &&
+                           (((instr.op == IROp::Mul || instr.op == IROp::And) && v.value == 0) ||
+                            (instr.op == IROp::Or && v.value != 0));
+                };
+                if (absorbs(x) || absorbs(y)) {
+                    result = {Constant, instr.op == IROp::Or ? 1 : 0};
+                } else if (x.state == Overdefined || y.state == Overdefined) {
+                    result = {Overdefined, 0};
+                } else if (x.state == Undefined || y.state == Undefined) {
+                    result = {Undefined, 0};
+                } else {
+                    int value;
+                    if (foldBinary(instr.op, x.value, y.value, value)) {
+                        result = {Constant, value};
+                    }
+                }
+                break;
+            }
+        }
+
+        LatticeValue& current = lattice[instr.dst];
+        if (current.state != Undefined) {
+            result = meet(current, result);
+        }
+        if (!(result == current)) {
+            current = result;
+            ssaWork.push_back(instr.dst);
+        }
+    };
+
+    blockVisited[0] = true;
+    for (size_t i = 0; i < func.blocks[0].instrs.size(); i++) {
+        evaluate(0, i);
+    }
+    while (!flowWork.empty() || !ssaWork.empty()) {
+        while (!flowWork.empty()) {
+            int b = flowWork.back();
+            flowWork.pop_back();
+            const auto& instrs = func.blocks[b].instrs;
+            // 首次到达时求值整个块，之后新增的入边只影响phi
+            bool first = !blockVisited[b];
+            blockVisited[b] = true;
+            for (size_t i = 0; i < instrs.size() && (first || instrs[i].op == IROp::Phi); i++) {
+                evaluate(b, i);
+            }
+        }
+        while (!ssaWork.empty()) {
+            int v = ssaWork.back();
+            ssaWork.pop_back();
+            for (const auto& use : uses[v]) {
+                if (blockVisited[use.first]) {
+                    evaluate(use.first, use.second);
+                }
+            }
+        }
+    }
+
+    // 常量结果改写为const，常量条件的分支改写为无条件跳转
+    for (int b = 0; b < blockCount; b++) {
+        if (!blockVisited[b]) {
+            continue;
+        }
+        auto& block = func.blocks[b];
+        for (auto& instr : block.instrs) {
+            if (instr.dst >= 0 && instr.op != IROp::Const && instr.op != IROp::Call &&
+                lattice[instr.dst].state == Constant) {
+                instr = IRInstr(IROp::Const, instr.dst, -1, -1, lattice[instr.dst].value);
+            } else if (instr.op == IROp::Branch && lattice[instr.a].state == Constant) {
+                block.succs = {block.succs[lattice[instr.a].value != 0 ? 0 : 1]};
+                instr = IRInstr(IROp::Jump);
+            }
+        }
+        std::stable_partition(block.instrs.begin(), block.instrs.end(),
+                              [](const IRInstr& instr) { return instr.op == IROp::Phi; });
+    }
+    func.rebuildCFG();
+}
+
+void Optimizer::mergeBlocks() {
+    // 唯一后继且该后继只有唯一前驱时，把后继块并入当前块
+    IRFunction& func = *function;
+    bool merged = false;
+    for (size_t a = 0; a < func.blocks.size(); a++) {
+        while (func.blocks[a].succs.size() == 1) {
+            int b = func.blocks[a].succs[0];
+            BasicBlock& next = func.blocks[b];
+            if (b == 0 || b == (int)a || next.preds.size() != 1) {
+                break;
+            }
+            BasicBlock& block = func.blocks[a];
+            block.instrs.pop_back();
+            for (auto& instr : next.instrs) {
+                if (instr.op == IROp::Phi) {
+                    instr = IRInstr(IROp::Copy, instr.dst, func.phiInputs[instr.a].value);
+                }
+                block.instrs.push_back(instr);
+            }
+            block.succs = next.succs;
+            for (int succ : next.succs) {
+                std::replace(func.blocks[succ].preds.begin(), func.blocks[succ].preds.end(), b, (int)a);
+                for (const auto& instr : func.blocks[succ].instrs) {
+                    for (int i = 0; instr.op == IROp::Phi && i < instr.b; i++) {
+                        if (func.phiInputs[instr.a + i].block == b) {
+                            func.phiInputs[instr.a + i].block = a;
+                        }
+                    }
+                }
+            }
+            next.instrs.clear();
+            next.succs.clear();
+            next.preds.clear();
+            merged = true;
+        }
+    }
+    if (merged) {
+        func.rebuildCFG();
+    }
+}
+
+void Optimizer::propagateCopies() {
+    // SSA中 x = copy y 的所有使用都可直接改读y；
+    // 所有输入（除自身外）都相同的phi同样等价于复制
+    IRFunction& func = *function;
+    std::vector<int> replacement(func.vregCount, -1);
+    auto resolve = [&](int v) {
+        while (replacement[v] >= 0) {
+            v = replacement[v];
+        }
+        return v;
+    };
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (const auto& block : func.blocks) {
+            for (const auto& instr : block.instrs) {
+                if (instr.dst < 0 || replacement[instr.dst] >= 0) {
+                    continue;
+                }
+                int source = -1;
+                if (instr.op == IROp::Copy) {
+                    source = resolve(instr.a);
+                } else if (instr.op == IROp::Phi) {
+                    for (int i = 0; i < instr.b; i++) {
+                        int value = resolve(func.phiInputs[instr.a + i].value);
+                        if (value == instr.dst || value == source) {
+                            continue;
+                        }
+                        source = source < 0 ? value : -2;
+                        if (source == -2) {
+                            break;
+                        }
+                    }
+                }
+                if (source >= 0 && source != instr.dst) {
+                    replacement[instr.dst] = source;
+                    changed = true;
+                }
+            }
+        }
+    }
+
+    for (int v = 0; v < func.vregCount; v++) {
+        if (replacement[v] >= 0) {
+            replacement[v] = resolve(v);
+        }
+    }
+    for (auto& block : func.blocks) {
+        for (auto& instr : block.instrs) {
+            replaceUses(func, instr, replacement);
+        }
+    }
+}
+
+void Optimizer::eliminateDeadCode() {
+    // 从有副作用的指令出发标记其依赖的定义，未被标记的指令删除
+    IRFunction& func = *function;
+    std::vector<std::pair<int, int>> defSite(func.vregCount, {-1, -1});
+    std::vector<std::vector<char>> live(func.blocks.size());
+    std::vector<std::pair<int, int>> worklist;
+    for (size_t b = 0; b < func.blocks.size(); b++) {
+        const auto& instrs = func.blocks[b].instrs;
+        live[b].assign(instrs.size(), 0);
+        for (size_t i = 0; i < instrs.size(); i++) {
+            if (instrs[i].dst >= 0) {
+                defSite[instrs[i].dst] = {b, i};
+            }
+            if (instrs[i].op == IROp::Call || instrs[i].isTerminator()) {
+                live[b][i] = 1;
+                worklist.emplace_back(b, i);
+            }
+        }
+    }
+
+    while (!worklist.empty()) {
+        auto site = worklist.back();
+        worklist.pop_back();
+        forEachUse(func, func.blocks[site.first].instrs[site.second], [&](int v) {
+            auto def = defSite[v];
+            if (def.first >= 0 && !live[def.first][def.second]) {
+                live[def.first][def.second] = 1;
+                worklist.push_back(def);
+            }
+        });
+    }
+
+    for (size_t b = 0; b < func.blocks.size(); b++) {
+        auto& instrs = func.blocks[b].instrs;
+        size_t kept = 0;
+        for (size_t i = 0; i < instrs.size(); i++) {
+            if (live[b][i]) {
+                instrs[kept++] = instrs[i];
+            }
+        }
+        instrs.erase(instrs.begin() + kept, instrs.end());
+    }
+}
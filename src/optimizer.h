@@ -0,0 +1,26 @@
+#ifndef OPTIMIZER_H
+#define OPTIMIZER_H
+
+#include "ir.h"
+
+// IR优化器：先做循环旋转，再在SSA形式上依次执行
+//   稀疏条件常量传播（SCCP）、CFG合并、复制传播、循环优化（LICM、归纳变量强度削减）、
+//   再次常量传播与复制传播（化简循环优化新生成的指令）、死代码删除，
+// 最后析构SSA交给后端。
+class Optimizer {
+private:
+    IRFunction* function;
+
+    void propagateConstants();
+    void mergeBlocks();
+    void propagateCopies();
+    void eliminateDeadCode();
+
+public:
+    Optimizer() : function(nullptr) {}
+
+    void run(IRProgram& program);
+    void run(IRFunction& func);
+};
+
+#endif // OPTIMIZER_H
@@ -0,0 +1,64 @@
+#include "output.h"
+
+// BufferSink 实现
+BufferSink::BufferSink(size_t reserveBytes) {
+    buffer.reserve(reserveBytes);
+}
+
+void BufferSink::write(const std::string& text) {
+    buffer += text;
+}
+
+// FileSink 实现
+FileSink::FileSink(FILE* stream, size_t bufferBytes)
+    : file(stream), ownsFile(false), failed(false), capacity(bufferBytes) {
+    buffer.reserve(capacity);
+}
+
+FileSink::~FileSink() {
+    flush();
+    if (ownsFile && file) {
+        fclose(file);
+    }
+}
+
+std::unique_ptr<FileSink> FileSink::open(const std::string& path, size_t bufferBytes) {
+    FILE* stream = fopen(path.c_str(), "wb");
+    if (!stream) {
+        return nullptr;
+    }
+    // 自己管理缓冲，关闭stdio的二次缓冲
+    setvbuf(stream, nullptr, _IONBF, 0);
+    std::unique_ptr<FileSink> sink(new FileSink(stream, bufferBytes));
+    sink->ownsFile = true;
+    return sink;
+}
+
+bool FileSink::writeOut(const char* data, size_t size) {
+    if (size > 0 && fwrite(data, 1, size, file) != size) {
+        failed = true;
+    }
+    return !failed;
+}
+
+void FileSink::write(const std::string& text) {
+    if (buffer.size() + text.size() > capacity) {
+        writeOut(buffer.data(), buffer.size());
+        buffer.clear();
+        // 超过缓冲容量的大块内容直接写出
+        if (text.size() > capacity) {
+            writeOut(text.data(), text.size());
+            return;
+        }
+    }
+    buffer += text;
+}
+
+bool FileSink::flush() {
+    writeOut(buffer.data(), buffer.size());
+    buffer.clear();
+    if (fflush(file) != 0) {
+        failed = true;
+    }
+    return !failed;
+}
@@ -0,0 +1,54 @@
+#ifndef OUTPUT_H
+#define OUTPUT_H
+
+#include <cstdio>
+#include <memory>
+#include <string>
+
+// 汇编输出目标抽象
+// 代码生成器按函数整块写入，具体落地方式由实现决定
+class OutputSink {
+public:
+    virtual ~OutputSink() = default;
+    
+    virtual void write(const std::string& text) = 0;
+    virtual bool flush() = 0;   // 将已写入的内容全部提交，失败返回false
+};
+
+// 内存输出：全部内容保存在一个大缓冲区中
+class BufferSink : public OutputSink {
+private:
+    std::string buffer;
+
+public:
+    explicit BufferSink(size_t reserveBytes = 1 << 20);
+    
+    void write(const std::string& text) override;
+    bool flush() override { return true; }
+    const std::string& str() const { return buffer; }
+};
+
+// 文件输出：内容先在大块缓冲中积累，缓冲满或flush时一次性写出
+class FileSink : public OutputSink {
+private:
+    FILE* file;
+    bool ownsFile;          // 是否由本对象负责关闭文件
+    bool failed;            // 是否发生过写入错误
+    std::string buffer;
+    size_t capacity;
+    
+    bool writeOut(const char* data, size_t size);
+
+public:
+    // 写入已打开的流（如stdout），不接管其生命周期
+    explicit FileSink(FILE* stream, size_t bufferBytes = 1 << 20);
+    ~FileSink() override;
+    
+    // 打开输出文件，失败时返回nullptr
+    static std::unique_ptr<FileSink> open(const std::string& path, size_t bufferBytes = 1 << 20);
+    
+    void write(const std::string& text) override;
+    bool flush() override;
+};
+
+#endif // OUTPUT_H
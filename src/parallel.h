@@ -0,0 +1,38 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+// 用至多jobs个线程执行 task(0) ... task(count-1)，全部完成后返回。
+// 各线程从共享计数器逐个领取下标：先做完的线程继续领取，耗时不均的任务也能分摊到所有线程。
+// 任务之间不得共享可变状态；只有一个线程可用时直接在当前线程按顺序执行
+template<typename Task>
+void parallelFor(size_t count, unsigned jobs, Task task) {
+    size_t threadCount = std::min<size_t>(jobs, count);
+    if (threadCount <= 1) {
+        for (size_t i = 0; i < count; i++) {
+            task(i);
+        }
+        return;
+    }
+    std::atomic<size_t> next(0);
+    auto worker = [&]() {
+        for (size_t i; (i = next.fetch_add(1, std::memory_order_relaxed)) < count; ) {
+            task(i);
+        }
+    };
+    std::vector<std::thread> threads;
+    for (size_t t = 1; t < threadCount; t++) {
+        threads.emplace_back(worker);
+    }
+    worker();   // 当前线程也参与
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
+
+#endif // PARALLEL_H
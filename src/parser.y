@@ -1,29 +1,21 @@
+%code requires {
+class CompileContext;
+}
+
 %{
 #include "ast.h"
+#include "context.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-extern int yylex();
-extern int yylineno;
-extern FILE* yyin;
-
-void yyerror(const char* msg);
+void yyerror(CompileContext* context, const char* msg);
 
-// strdup函数的简单实现
-#ifndef strdup
-static char* strdup(const char* s) {
-    size_t len = strlen(s) + 1;
-    char* result = (char*)malloc(len);
-    if (result) {
-        memcpy(result, s, len);
-    }
-    return result;
+// 在本次编译的内存池中创建AST节点
+template<typename T, typename... Args>
+T* makeNode(CompileContext* context, Args&&... args) {
+    return context->arena.make<T>(std::forward<Args>(args)...);
 }
-#endif
-
-// 全局变量存储解析结果
-Program* program_root = nullptr;
 
 // 辅助函数：为AST节点设置行号
 template<typename T>
@@ -35,9 +27,15 @@ T* setLineNumber(T* node, int line) {
 }
 %}
 
+/* 纯（可重入）分析器：不使用全局变量，状态都在CompileContext中 */
+%define api.pure full
+%parse-param {CompileContext* context}
+%lex-param {CompileContext* context}
+
 %union {
     int intval;
-    char* strval;
+    Name name;
+    TypeId type;
     ASTNode* node;
     Expression* expr;
     Statement* stmt;
@@ -45,22 +43,28 @@ T* setLineNumber(T* node, int line) {
     FunctionDefinition* func_def;
     VariableDeclaration* var_decl;
     CompoundStatement* compound_stmt;
-    std::vector<std::unique_ptr<Statement>>* stmt_list;
-    std::vector<std::string>* str_list;
-    std::vector<std::pair<std::string, std::string>>* param_list;
-    std::vector<std::unique_ptr<Expression>>* expr_list;
-    std::vector<std::pair<std::string, std::unique_ptr<Expression>>>* init_decl_list;
-    std::pair<std::string, std::unique_ptr<Expression>>* init_decl;
+    std::vector<Statement*>* stmt_list;
+    std::vector<Name>* name_list;
+    std::vector<std::pair<TypeId, Name>>* param_list;
+    std::vector<Expression*>* expr_list;
+    std::vector<std::pair<Name, Expression*>>* init_decl_list;
+    std::pair<Name, Expression*>* init_decl;
 }
 
 /* 终结符定义 */
 %token <intval> INTEGER_LITERAL
-%token <strval> IDENTIFIER
+%token <name> IDENTIFIER
 %token INT CHAR FLOAT DOUBLE VOID
 %token IF ELSE WHILE FOR RETURN BREAK CONTINUE
 %token EQ NE LE GE AND OR INC DEC
 %token ERROR_TOKEN
 
+%code {
+static int yylex(YYSTYPE* value, CompileContext* context) {
+    return context->lexer.next(*value);
+}
+}
+
 /* 非终结符类型定义 */
 %type <program> program
 %type <node> declaration
@@ -80,8 +84,8 @@ T* setLineNumber(T* node, int line) {
 %type <expr> unary_expression
 %type <expr> primary_expression
 %type <expr> postfix_expression
-%type <strval> type_specifier
-%type <str_list> identifier_list
+%type <type> type_specifier
+%type <name_list> identifier_list
 %type <param_list> parameter_list
 %type <expr_list> argument_list
 %type <init_decl_list> init_declarator_list
@@ -103,13 +107,13 @@ T* setLineNumber(T* node, int line) {
 program:
     /* empty */
     {
-        $$ = new Program();
-        program_root = $$;
+        $$ = makeNode<Program>(context, &context->arena);
+        context->program = $$;
     }
     | program declaration
     {
         $$ = $1;
-        $$->declarations.push_back(std::unique_ptr<ASTNode>($2));
+        $$->declarations.push_back($2);
     }
     ;
 
@@ -127,18 +131,14 @@ declaration:
 function_definition:
     type_specifier IDENTIFIER '(' ')' compound_statement
     {
-        $$ = setLineNumber(new FunctionDefinition($1, $2), yylineno);
-        $$->body = std::unique_ptr<CompoundStatement>($5);
-        free($1);
-        free($2);
+        $$ = setLineNumber(makeNode<FunctionDefinition>(context, $1, $2), context->line());
+        $$->body = $5;
     }
     | type_specifier IDENTIFIER '(' parameter_list ')' compound_statement
     {
-        $$ = setLineNumber(new FunctionDefinition($1, $2), yylineno);
+        $$ = setLineNumber(makeNode<FunctionDefinition>(context, $1, $2), context->line());
         $$->parameters = *$4;
-        $$->body = std::unique_ptr<CompoundStatement>($6);
-        free($1);
-        free($2);
+        $$->body = $6;
         delete $4;
     }
     ;
@@ -146,33 +146,27 @@ function_definition:
 parameter_list:
     type_specifier IDENTIFIER
     {
-        $$ = new std::vector<std::pair<std::string, std::string>>();
+        $$ = new std::vector<std::pair<TypeId, Name>>();
         $$->push_back(std::make_pair($1, $2));
-        free($1);
-        free($2);
     }
     | parameter_list ',' type_specifier IDENTIFIER
     {
         $$ = $1;
         $$->push_back(std::make_pair($3, $4));
-        free($3);
-        free($4);
     }
     ;
 
 variable_declaration:
     type_specifier identifier_list
     {
-        $$ = setLineNumber(new VariableDeclaration($1), yylineno);
+        $$ = setLineNumber(makeNode<VariableDeclaration>(context, $1), context->line());
         $$->names = *$2;
-        free($1);
         delete $2;
     }
     | type_specifier init_declarator_list
     {
-        $$ = setLineNumber(new VariableDeclaration($1), yylineno);
+        $$ = setLineNumber(makeNode<VariableDeclaration>(context, $1), context->line());
         $$->initDeclarators = std::move(*$2);
-        free($1);
         delete $2;
     }
     ;
@@ -180,22 +174,20 @@ variable_declaration:
 identifier_list:
     IDENTIFIER
     {
-        $$ = new std::vector<std::string>();
+        $$ = new std::vector<Name>();
         $$->push_back($1);
-        free($1);
     }
     | identifier_list ',' IDENTIFIER
     {
         $$ = $1;
         $$->push_back($3);
-        free($3);
     }
     ;
 
 init_declarator_list:
     init_declarator
     {
-        $$ = new std::vector<std::pair<std::string, std::unique_ptr<Expression>>>();
+        $$ = new std::vector<std::pair<Name, Expression*>>();
         $$->push_back(std::move(*$1));
         delete $1;
     }
@@ -210,32 +202,30 @@ init_declarator_list:
 init_declarator:
     IDENTIFIER
     {
-        $$ = new std::pair<std::string, std::unique_ptr<Expression>>($1, nullptr);
-        free($1);
+        $$ = new std::pair<Name, Expression*>($1, nullptr);
     }
     | IDENTIFIER '=' assignment_expression
     {
-        $$ = new std::pair<std::string, std::unique_ptr<Expression>>($1, std::unique_ptr<Expression>($3));
-        free($1);
+        $$ = new std::pair<Name, Expression*>($1, $3);
     }
     ;
 
 type_specifier:
-    INT     { $$ = strdup("int"); }
-    | CHAR  { $$ = strdup("char"); }
-    | FLOAT { $$ = strdup("float"); }
-    | DOUBLE { $$ = strdup("double"); }
-    | VOID  { $$ = strdup("void"); }
+    INT     { $$ = TypeKind::Int; }
+    | CHAR  { $$ = TypeKind::Char; }
+    | FLOAT { $$ = TypeKind::Float; }
+    | DOUBLE { $$ = TypeKind::Double; }
+    | VOID  { $$ = TypeKind::Void; }
     ;
 
 compound_statement:
     '{' '}'
     {
-        $$ = new CompoundStatement();
+        $$ = makeNode<CompoundStatement>(context);
     }
     | '{' statement_list '}'
     {
-        $$ = new CompoundStatement();
+        $$ = makeNode<CompoundStatement>(context);
         $$->statements = std::move(*$2);
         delete $2;
     }
@@ -244,20 +234,20 @@ compound_statement:
 statement_list:
     statement
     {
-        $$ = new std::vector<std::unique_ptr<Statement>>();
-        $$->push_back(std::unique_ptr<Statement>($1));
+        $$ = new std::vector<Statement*>();
+        $$->push_back($1);
     }
     | statement_list statement
     {
         $$ = $1;
-        $$->push_back(std::unique_ptr<Statement>($2));
+        $$->push_back($2);
     }
     ;
 
 statement:
     expression ';'
     {
-        $$ = new ExpressionStatement(std::unique_ptr<Expression>($1));
+        $$ = makeNode<ExpressionStatement>(context, $1);
     }
     | compound_statement
     {
@@ -269,30 +259,29 @@ statement:
     }
     | IF '(' expression ')' statement
     {
-        $$ = new IfStatement(std::unique_ptr<Expression>($3), std::unique_ptr<Statement>($5));
+        $$ = makeNode<IfStatement>(context, $3, $5);
     }
     | IF '(' expression ')' statement ELSE statement
     {
-        auto if_stmt = new IfStatement(std::unique_ptr<Expression>($3), std::unique_ptr<Statement>($5));
-        if_stmt->elseStmt = std::unique_ptr<Statement>($7);
+        auto if_stmt = makeNode<IfStatement>(context, $3, $5);
+        if_stmt->elseStmt = $7;
         $$ = if_stmt;
     }
     | WHILE '(' expression ')' statement
     {
-        $$ = new WhileStatement(std::unique_ptr<Expression>($3), std::unique_ptr<Statement>($5));
+        $$ = makeNode<WhileStatement>(context, $3, $5);
     }
     | FOR '(' statement expression ';' expression ')' statement
     {
-        $$ = new ForStatement(std::unique_ptr<Statement>($3), std::unique_ptr<Expression>($4), 
-                             std::unique_ptr<Expression>($6), std::unique_ptr<Statement>($8));
+        $$ = makeNode<ForStatement>(context, $3, $4, $6, $8);
     }
     | RETURN ';'
     {
-        $$ = new ReturnStatement();
+        $$ = makeNode<ReturnStatement>(context);
     }
     | RETURN expression ';'
     {
-        $$ = new ReturnStatement(std::unique_ptr<Expression>($2));
+        $$ = makeNode<ReturnStatement>(context, $2);
     }
     ;
 
@@ -310,11 +299,8 @@ assignment_expression:
     }
     | IDENTIFIER '=' assignment_expression
     {
-        $$ = setLineNumber(new AssignmentExpression(
-            std::unique_ptr<Identifier>(setLineNumber(new Identifier($1), yylineno)),
-            std::unique_ptr<Expression>($3)
-        ), yylineno);
-        free($1);
+        $$ = setLineNumber(makeNode<AssignmentExpression>(context, 
+            setLineNumber(makeNode<Identifier>(context, $1), context->line()), $3), context->line());
     }
     ;
 
@@ -325,11 +311,7 @@ logical_or_expression:
     }
     | logical_or_expression OR logical_and_expression
     {
-        $$ = new BinaryExpression(
-            std::unique_ptr<Expression>($1),
-            "||",
-            std::unique_ptr<Expression>($3)
-        );
+        $$ = makeNode<BinaryExpression>(context, $1, BinaryOp::LogicalOr, $3);
     }
     ;
 
@@ -340,11 +322,7 @@ logical_and_expression:
     }
     | logical_and_expression AND equality_expression
     {
-        $$ = new BinaryExpression(
-            std::unique_ptr<Expression>($1),
-            "&&",
-            std::unique_ptr<Expression>($3)
-        );
+        $$ = makeNode<BinaryExpression>(context, $1, BinaryOp::LogicalAnd, $3);
     }
     ;
 
@@ -355,19 +333,11 @@ equality_expression:
     }
     | equality_expression EQ relational_expression
     {
-        $$ = new BinaryExpression(
-            std::unique_ptr<Expression>($1),
-            "==",
-            std::unique_ptr<Expression>($3)
-        );
+        $$ = makeNode<BinaryExpression>(context, $1, BinaryOp::Eq, $3);
     }
     | equality_expression NE relational_expression
     {
-        $$ = new BinaryExpression(
-            std::unique_ptr<Expression>($1),
-            "!=",
-            std::unique_ptr<Expression>($3)
-        );
+        $$ = makeNode<BinaryExpression>(context, $1, BinaryOp::Ne, $3);
     }
     ;
 
@@ -378,35 +348,19 @@ relational_expression:
     }
     | relational_expression '<' additive_expression
     {
-        $$ = new BinaryExpression(
-            std::unique_ptr<Expression>($1),
-            "<",
-            std::unique_ptr<Expression>($3)
-        );
+        $$ = makeNode<BinaryExpression>(context, $1, BinaryOp::Lt, $3);
     }
     | relational_expression '>' additive_expression
     {
-        $$ = new BinaryExpression(
-            std::unique_ptr<Expression>($1),
-            ">",
-            std::unique_ptr<Expression>($3)
-        );
+        $$ = makeNode<BinaryExpression>(context, $1, BinaryOp::Gt, $3);
     }
     | relational_expression LE additive_expression
     {
-        $$ = new BinaryExpression(
-            std::unique_ptr<Expression>($1),
-            "<=",
-            std::unique_ptr<Expression>($3)
-        );
+        $$ = makeNode<BinaryExpression>(context, $1, BinaryOp::Le, $3);
     }
     | relational_expression GE additive_expression
     {
-        $$ = new BinaryExpression(
-            std::unique_ptr<Expression>($1),
-            ">=",
-            std::unique_ptr<Expression>($3)
-        );
+        $$ = makeNode<BinaryExpression>(context, $1, BinaryOp::Ge, $3);
     }
     ;
 
@@ -417,19 +371,11 @@ additive_expression:
     }
     | additive_expression '+' multiplicative_expression
     {
-        $$ = setLineNumber(new BinaryExpression(
-            std::unique_ptr<Expression>($1),
-            "+",
-            std::unique_ptr<Expression>($3)
-        ), yylineno);
+        $$ = setLineNumber(makeNode<BinaryExpression>(context, $1, BinaryOp::Add, $3), context->line());
     }
     | additive_expression '-' multiplicative_expression
     {
-        $$ = setLineNumber(new BinaryExpression(
-            std::unique_ptr<Expression>($1),
-            "-",
-            std::unique_ptr<Expression>($3)
-        ), yylineno);
+        $$ = setLineNumber(makeNode<BinaryExpression>(context, $1, BinaryOp::Sub, $3), context->line());
     }
     ;
 
@@ -440,27 +386,15 @@ multiplicative_expression:
     }
     | multiplicative_expression '*' unary_expression
     {
-        $$ = new BinaryExpression(
-            std::unique_ptr<Expression>($1),
-            "*",
-            std::unique_ptr<Expression>($3)
-        );
+        $$ = makeNode<BinaryExpression>(context, $1, BinaryOp::Mul, $3);
     }
     | multiplicative_expression '/' unary_expression
     {
-        $$ = new BinaryExpression(
-            std::unique_ptr<Expression>($1),
-            "/",
-            std::unique_ptr<Expression>($3)
-        );
+        $$ = makeNode<BinaryExpression>(context, $1, BinaryOp::Div, $3);
     }
     | multiplicative_expression '%' unary_expression
     {
-        $$ = new BinaryExpression(
-            std::unique_ptr<Expression>($1),
-            "%",
-            std::unique_ptr<Expression>($3)
-        );
+        $$ = makeNode<BinaryExpression>(context, $1, BinaryOp::Mod, $3);
     }
     ;
 
@@ -471,11 +405,11 @@ unary_expression:
     }
     | '-' unary_expression %prec UMINUS
     {
-        $$ = new UnaryExpression("-", std::unique_ptr<Expression>($2));
+        $$ = makeNode<UnaryExpression>(context, UnaryOp::Neg, $2);
     }
     | '!' unary_expression
     {
-        $$ = new UnaryExpression("!", std::unique_ptr<Expression>($2));
+        $$ = makeNode<UnaryExpression>(context, UnaryOp::Not, $2);
     }
     ;
 
@@ -486,15 +420,13 @@ postfix_expression:
     }
     | IDENTIFIER '(' ')'
     {
-        $$ = setLineNumber(new FunctionCall($1), yylineno);
-        free($1);
+        $$ = setLineNumber(makeNode<FunctionCall>(context, $1), context->line());
     }
     | IDENTIFIER '(' argument_list ')'
     {
-        auto func_call = setLineNumber(new FunctionCall($1), yylineno);
+        auto func_call = setLineNumber(makeNode<FunctionCall>(context, $1), context->line());
         func_call->arguments = std::move(*$3);
         $$ = func_call;
-        free($1);
         delete $3;
     }
     ;
@@ -502,25 +434,24 @@ postfix_expression:
 argument_list:
     expression
     {
-        $$ = new std::vector<std::unique_ptr<Expression>>();
-        $$->push_back(std::unique_ptr<Expression>($1));
+        $$ = new std::vector<Expression*>();
+        $$->push_back($1);
     }
     | argument_list ',' expression
     {
         $$ = $1;
-        $$->push_back(std::unique_ptr<Expression>($3));
+        $$->push_back($3);
     }
     ;
 
 primary_expression:
     IDENTIFIER
     {
-        $$ = setLineNumber(new Identifier($1), yylineno);
-        free($1);
+        $$ = setLineNumber(makeNode<Identifier>(context, $1), context->line());
     }
     | INTEGER_LITERAL
     {
-        $$ = setLineNumber(new IntegerLiteral($1), yylineno);
+        $$ = setLineNumber(makeNode<IntegerLiteral>(context, $1), context->line());
     }
     | '(' expression ')'
     {
@@ -530,14 +461,14 @@ primary_expression:
 
 %%
 
-void yyerror(const char* msg) {
+void yyerror(CompileContext* context, const char* msg) {
     if (strstr(msg, "syntax error") != NULL) {
-        fprintf(stderr, "[语法错误] 行 %d: 语法结构不正确，可能的原因包括：\n", yylineno);
-        fprintf(stderr, "  - 缺少分号、括号或大括号\n");
-        fprintf(stderr, "  - 表达式语法错误\n");
-        fprintf(stderr, "  - 函数定义或变量声明格式错误\n");
-        fprintf(stderr, "  - 使用了不支持的语法特性\n");
+        context->diagnostics.report(stderr, "[语法错误] 行 %d: 语法结构不正确，可能的原因包括：\n", context->line());
+        context->diagnostics.report(stderr, "  - 缺少分号、括号或大括号\n");
+        context->diagnostics.report(stderr, "  - 表达式语法错误\n");
+        context->diagnostics.report(stderr, "  - 函数定义或变量声明格式错误\n");
+        context->diagnostics.report(stderr, "  - 使用了不支持的语法特性\n");
     } else {
-        fprintf(stderr, "[语法错误] 行 %d: %s\n", yylineno, msg);
+        context->diagnostics.report(stderr, "[语法错误] 行 %d: %s\n", context->line(), msg);
     }
 } 
\ No newline at end of file
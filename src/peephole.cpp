@@ -0,0 +1,223 @@
+#include "peephole.h"
+#include "regalloc.h"
+#include <algorithm>
+#include <sstream>
+
+namespace {
+
+bool isRegister(const std::string& operand) {
+    return !operand.empty() && operand[0] == '%';
+}
+
+bool isMemory(const std::string& operand) {
+    return !operand.empty() && operand.back() == ')';
+}
+
+bool isInstruction(const std::vector<AsmInstr>& code, size_t i, const char* opcode) {
+    return i < code.size() && code[i].kind == AsmKind::Instruction && code[i].opcode == opcode;
+}
+
+// i之后第一条未被删除的汇编行
+size_t nextLive(const std::vector<AsmInstr>& code, size_t i) {
+    do {
+        i++;
+    } while (i < code.size() && code[i].kind == AsmKind::Removed);
+    return i;
+}
+
+bool readsFlags(const std::string& opcode) {
+    return (opcode[0] == 'j' && opcode != "jmp") || opcode.compare(0, 3, "set") == 0 ||
+           opcode.compare(0, 4, "cmov") == 0;
+}
+
+bool writesFlags(const std::string& opcode) {
+    static const char* const kWriters[] = {
+        "cmpq", "testq", "addq", "subq", "imulq", "andq", "orq", "xorl", "xorq",
+        "negq", "shlq", "sarq", "idivq", "call"
+    };
+    for (const char* writer : kWriters) {
+        if (opcode == writer) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// 位置i之后的代码是否还会读取当前的标志位（标志位不跨基本块使用）
+bool flagsLiveAfter(const std::vector<AsmInstr>& code, size_t i) {
+    for (size_t j = nextLive(code, i); j < code.size(); j = nextLive(code, j)) {
+        const AsmInstr& instr = code[j];
+        if (instr.kind == AsmKind::Label || instr.opcode == "jmp" || instr.opcode == "ret") {
+            return false;
+        }
+        if (readsFlags(instr.opcode)) {
+            return true;
+        }
+        if (writesFlags(instr.opcode)) {
+            return false;
+        }
+    }
+    return false;
+}
+
+const char* register32(const std::string& reg64) {
+    for (int reg = 0; reg < PHYS_REG_COUNT; reg++) {
+        if (reg64 == regName64(reg)) {
+            return regName32(reg);
+        }
+    }
+    return nullptr;
+}
+
+// movq %r, M; movq M, %s  =>  movq %r, M; movq %r, %s（%s与%r相同时删除读回）
+bool forwardStore(std::vector<AsmInstr>& code, size_t i) {
+    const AsmInstr& store = code[i];
+    if (store.opcode != "movq" || !isRegister(store.src) || !isMemory(store.dst)) {
+        return false;
+    }
+    size_t j = nextLive(code, i);
+    if (!isInstruction(code, j, "movq") || code[j].src != store.dst || !isRegister(code[j].dst)) {
+        return false;
+    }
+    if (code[j].dst == store.src) {
+        code[j].kind = AsmKind::Removed;
+    } else {
+        code[j].src = store.src;
+    }
+    return true;
+}
+
+// movq $0, %reg  =>  xorl %reg32, %reg32（写32位寄存器会清零高32位）
+bool zeroRegister(std::vector<AsmInstr>& code, size_t i) {
+    AsmInstr& instr = code[i];
+    if (instr.opcode != "movq" || instr.src != "$0" || !isRegister(instr.dst) || flagsLiveAfter(code, i)) {
+        return false;
+    }
+    const char* reg32 = register32(instr.dst);
+    if (!reg32) {
+        return false;
+    }
+    instr = AsmInstr(AsmKind::Instruction, "xorl", reg32, reg32);
+    return true;
+}
+
+// jmp L 之后紧跟（若干标签中包含）L
+bool jumpToNext(std::vector<AsmInstr>& code, size_t i) {
+    if (code[i].opcode != "jmp") {
+        return false;
+    }
+    for (size_t j = nextLive(code, i); j < code.size() && code[j].kind == AsmKind::Label; j = nextLive(code, j)) {
+        if (code[j].opcode == code[i].src) {
+            code[i].kind = AsmKind::Removed;
+            return true;
+        }
+    }
+    return false;
+}
+
+// movq x, x
+bool selfMove(std::vector<AsmInstr>& code, size_t i) {
+    if (code[i].opcode != "movq" || code[i].src != code[i].dst) {
+        return false;
+    }
+    code[i].kind = AsmKind::Removed;
+    return true;
+}
+
+const PeepholeRule kRules[] = {
+    {"store-reload", forwardStore},
+    {"zero-register", zeroRegister},
+    {"jump-to-next", jumpToNext},
+    {"self-move", selfMove},
+};
+
+const size_t kRuleCount = sizeof(kRules) / sizeof(kRules[0]);
+
+} // namespace
+
+void AsmInstr::print(std::string& out) const {
+    if (kind == AsmKind::Label) {
+        out += opcode;
+        out += ":\n";
+        return;
+    }
+    out += "    ";
+    out += opcode;
+    if (!src.empty()) {
+        out += ' ';
+        out += src;
+    }
+    if (!dst.empty()) {
+        out += ", ";
+        out += dst;
+    }
+    out += '\n';
+}
+
+PeepholeOptimizer::PeepholeOptimizer() : rewriteCounts(kRuleCount, 0) {
+}
+
+void PeepholeOptimizer::run(std::vector<AsmInstr>& code) {
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (size_t i = 0; i < code.size(); i++) {
+            for (size_t r = 0; r < kRuleCount && code[i].kind == AsmKind::Instruction; r++) {
+                if (kRules[r].apply(code, i)) {
+                    rewriteCounts[r]++;
+                    changed = true;
+                }
+            }
+        }
+    }
+    code.erase(std::remove_if(code.begin(), code.end(),
+                              [](const AsmInstr& instr) { return instr.kind == AsmKind::Removed; }),
+               code.end());
+}
+
+size_t PeepholeOptimizer::ruleCount() const {
+    return kRuleCount;
+}
+
+const char* PeepholeOptimizer::ruleName(size_t rule) const {
+    return kRules[rule].name;
+}
+
+int PeepholeOptimizer::totalRewrites() const {
+    int total = 0;
+    for (int count : rewriteCounts) {
+        total += count;
+    }
+    return total;
+}
+
+void PeepholeOptimizer::merge(const PeepholeOptimizer& other) {
+    for (size_t r = 0; r < rewriteCounts.size(); r++) {
+        rewriteCounts[r] += other.rewriteCounts[r];
+    }
+}
+
+std::string PeepholeOptimizer::saveCounts() const {
+    std::string text;
+    for (size_t r = 0; r < rewriteCounts.size(); r++) {
+        if (r > 0) {
+            text += ' ';
+        }
+        text += std::to_string(rewriteCounts[r]);
+    }
+    return text;
+}
+
+bool PeepholeOptimizer::mergeCounts(const std::string& text) {
+    std::istringstream in(text);
+    std::vector<int> counts(rewriteCounts.size());
+    for (int& count : counts) {
+        if (!(in >> count)) {
+            return false;
+        }
+    }
+    for (size_t r = 0; r < rewriteCounts.size(); r++) {
+        rewriteCounts[r] += counts[r];
+    }
+    return true;
+}
@@ -0,0 +1,61 @@
+#ifndef PEEPHOLE_H
+#define PEEPHOLE_H
+
+#include <string>
+#include <vector>
+
+// 汇编行的种类
+enum class AsmKind : unsigned char {
+    Instruction,
+    Label,
+    Removed     // 已被窥孔优化删除，写出前压缩掉
+};
+
+// 内存中的一条汇编：opcode src, dst（AT&T顺序，缺省操作数为空）
+struct AsmInstr {
+    AsmKind kind;
+    std::string opcode;     // 指令助记符；标签时为标签名
+    std::string src;
+    std::string dst;
+
+    AsmInstr(AsmKind k, const std::string& op, const std::string& s = "", const std::string& d = "")
+        : kind(k), opcode(op), src(s), dst(d) {}
+
+    void print(std::string& out) const;
+};
+
+// 窥孔规则：在位置i（及其后若干条）上尝试改写，成功返回true
+struct PeepholeRule {
+    const char* name;
+    bool (*apply)(std::vector<AsmInstr>& code, size_t i);
+};
+
+// 表驱动的窥孔优化器，逐函数在写出文本之前运行：
+//   - 存入栈槽后立即读回同一栈槽：读回改为寄存器间传送或删除
+//   - movq $0, %reg 改为 xorl（其后标志位不再被读取时）
+//   - 跳转到紧随其后的标签
+//   - 自身到自身的传送
+// 规则反复应用直到不再有改写；每条规则的改写次数累计在整个编译过程中
+class PeepholeOptimizer {
+private:
+    std::vector<int> rewriteCounts;     // 与规则表一一对应
+
+public:
+    PeepholeOptimizer();
+
+    void run(std::vector<AsmInstr>& code);
+
+    size_t ruleCount() const;
+    const char* ruleName(size_t rule) const;
+    int rewriteCount(size_t rule) const { return rewriteCounts[rule]; }
+    int totalRewrites() const;
+
+    void merge(const PeepholeOptimizer& other);  // 累加另一实例的改写次数
+
+    // 各规则的改写次数以空格分隔写成文本（随函数的汇编存入编译缓存），
+    // mergeCounts 累加这样的文本，格式不符时返回false
+    std::string saveCounts() const;
+    bool mergeCounts(const std::string& text);
+};
+
+#endif // PEEPHOLE_H
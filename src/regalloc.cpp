@@ -0,0 +1,275 @@
+#include "regalloc.h"
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+
+static const char* const kRegNames64[PHYS_REG_COUNT] = {
+    "%rax", "%rcx", "%rdx", "%rbx", "%rsi", "%rdi", "%r8", "%r9",
+    "%r10", "%r11", "%r12", "%r13", "%r14", "%r15",
+};
+static const char* const kRegNames32[PHYS_REG_COUNT] = {
+    "%eax", "%ecx", "%edx", "%ebx", "%esi", "%edi", "%r8d", "%r9d",
+    "%r10d", "%r11d", "%r12d", "%r13d", "%r14d", "%r15d",
+};
+static const char* const kRegNames8[PHYS_REG_COUNT] = {
+    "%al", "%cl", "%dl", "%bl", "%sil", "%dil", "%r8b", "%r9b",
+    "%r10b", "%r11b", "%r12b", "%r13b", "%r14b", "%r15b",
+};
+
+// 可分配寄存器：先用调用者保存寄存器，不够或跨调用时再用被调用者保存寄存器
+static const int kCallerSaved[] = {RCX, RSI, RDI, R8, R9, R10};
+static const int kCalleeSaved[] = {RBX, R12, R13, R14, R15};
+
+const char* regName64(int reg) {
+    return kRegNames64[reg];
+}
+
+const char* regName32(int reg) {
+    return kRegNames32[reg];
+}
+
+const char* regName8(int reg) {
+    return kRegNames8[reg];
+}
+
+// FrameLayout 实现
+int FrameLayout::allocateLocal() {
+    allocatedSize += 8; // 64位环境下使用8字节对齐
+    return allocatedSize;
+}
+
+int FrameLayout::allocateTemporary(int from) {
+    // 槽位必须在from之前就已空闲：被换出的区间从更早的位置起就要占用槽位
+    for (size_t i = freeTemporaries.size(); i > 0; i--) {
+        if (freeTemporaries[i - 1].second <= from) {
+            int offset = freeTemporaries[i - 1].first;
+            freeTemporaries.erase(freeTemporaries.begin() + (i - 1));
+            return offset;
+        }
+    }
+    allocatedSize += 8;
+    return allocatedSize;
+}
+
+void FrameLayout::releaseTemporary(int offset, int freeFrom) {
+    freeTemporaries.push_back({offset, freeFrom});
+}
+
+int FrameLayout::frameSize() const {
+    // pushq %rbp 之后%rsp已16字节对齐，帧大小保持16的倍数
+    return (allocatedSize + 15) & ~15;
+}
+
+void FrameLayout::reset() {
+    allocatedSize = 0;
+    freeTemporaries.clear();
+}
+
+// RegisterAllocator 实现
+RegisterAllocator::RegisterAllocator(const IRFunction& func, FrameLayout& layout)
+    : function(func), frame(layout), locations(func.vregCount) {
+}
+
+void RegisterAllocator::run() {
+    findConstants();
+    buildIntervals();
+    linearScan();
+}
+
+void RegisterAllocator::findConstants() {
+    std::vector<int> defCount(function.vregCount, 0);
+    for (const auto& block : function.blocks) {
+        for (const auto& instr : block.instrs) {
+            if (instr.dst >= 0) {
+                defCount[instr.dst]++;
+            }
+        }
+    }
+    for (const auto& block : function.blocks) {
+        for (const auto& instr : block.instrs) {
+            if (instr.op == IROp::Const && defCount[instr.dst] == 1) {
+                locations[instr.dst].isConstant = true;
+                locations[instr.dst].value = instr.imm;
+            }
+        }
+    }
+}
+
+void RegisterAllocator::buildIntervals() {
+    int blockCount = function.blocks.size();
+    int words = (function.vregCount + 63) / 64;
+    typedef std::vector<uint64_t> BitSet;
+    auto test = [](const BitSet& set, int v) { return (set[v >> 6] >> (v & 63)) & 1; };
+    auto insert = [](BitSet& set, int v) { set[v >> 6] |= uint64_t(1) << (v & 63); };
+
+    // 指令编号：按布局顺序每条指令占两个位置；入口处的param统一编号为0，
+    // 这样所有参数同时活跃，入口的并行搬移不会互相覆盖
+    std::vector<int> blockStart(blockCount), blockEnd(blockCount);
+    std::vector<BitSet> use(blockCount, BitSet(words)), def(blockCount, BitSet(words));
+    std::vector<int> first(function.vregCount, INT_MAX), last(function.vregCount, -1);
+    auto extend = [&](int v, int pos) {
+        first[v] = std::min(first[v], pos);
+        last[v] = std::max(last[v], pos);
+    };
+
+    int position = 2;
+    for (int b = 0; b < blockCount; b++) {
+        blockStart[b] = position;
+        for (const auto& instr : function.blocks[b].instrs) {
+            int pos = instr.op == IROp::Param ? 0 : position;
+            if (instr.op == IROp::Param) {
+                blockStart[b] = 0;
+                last[instr.dst] = std::max(last[instr.dst], 1);
+            } else {
+                position += 2;
+            }
+            if (instr.op == IROp::Call) {
+                callPositions.push_back(pos);
+            }
+            forEachUse(function, instr, [&](int v) {
+                if (!locations[v].isConstant) {
+                    extend(v, pos);
+                    if (!test(def[b], v)) {
+                        insert(use[b], v);
+                    }
+                }
+            });
+            if (instr.dst >= 0 && !locations[instr.dst].isConstant) {
+                extend(instr.dst, pos);
+                insert(def[b], instr.dst);
+            }
+        }
+        blockEnd[b] = position - 2;
+    }
+
+    // 活跃变量分析（逆序迭代到不动点）
+    std::vector<BitSet> liveIn(blockCount, BitSet(words)), liveOut(blockCount, BitSet(words));
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (int b = blockCount - 1; b >= 0; b--) {
+            BitSet out(words);
+            for (int succ : function.blocks[b].succs) {
+                for (int w = 0; w < words; w++) {
+                    out[w] |= liveIn[succ][w];
+                }
+            }
+            for (int w = 0; w < words; w++) {
+                uint64_t in = use[b][w] | (out[w] & ~def[b][w]);
+                if (in != liveIn[b][w] || out[w] != liveOut[b][w]) {
+                    changed = true;
+                }
+                liveIn[b][w] = in;
+                liveOut[b][w] = out[w];
+            }
+        }
+    }
+
+    // 跨块活跃的值延伸到块边界（不分裂区间，只保留最外层范围）
+    for (int b = 0; b < blockCount; b++) {
+        for (int v = 0; v < function.vregCount; v++) {
+            if (test(liveIn[b], v)) {
+                extend(v, blockStart[b]);
+            }
+            if (test(liveOut[b], v)) {
+                extend(v, blockEnd[b] + 1);
+            }
+        }
+    }
+
+    for (int v = 0; v < function.vregCount; v++) {
+        if (last[v] < 0) {
+            continue;
+        }
+        auto call = std::upper_bound(callPositions.begin(), callPositions.end(), first[v]);
+        bool crosses = call != callPositions.end() && *call < last[v];
+        intervals.push_back({v, first[v], last[v], crosses});
+    }
+    std::sort(intervals.begin(), intervals.end(), [](const LiveInterval& x, const LiveInterval& y) {
+        return x.start != y.start ? x.start < y.start : x.vreg < y.vreg;
+    });
+}
+
+void RegisterAllocator::linearScan() {
+    std::vector<LiveInterval*> active;     // 占用寄存器的区间
+    std::vector<LiveInterval*> spilled;    // 占用栈槽的区间
+    bool regFree[PHYS_REG_COUNT];
+    std::fill(regFree, regFree + PHYS_REG_COUNT, true);
+    bool calleeSavedTouched[PHYS_REG_COUNT] = {};
+
+    auto takeRegister = [&](LiveInterval& interval) {
+        for (int reg : kCallerSaved) {
+            if (!interval.crossesCall && regFree[reg]) {
+                return reg;
+            }
+        }
+        for (int reg : kCalleeSaved) {
+            if (regFree[reg]) {
+                return reg;
+            }
+        }
+        return -1;
+    };
+    auto isCalleeSaved = [](int reg) {
+        return std::find(std::begin(kCalleeSaved), std::end(kCalleeSaved), reg) != std::end(kCalleeSaved);
+    };
+
+    for (auto& current : intervals) {
+        // 释放已结束的区间（结束位置与当前起点相同的寄存器可以复用）
+        for (size_t i = 0; i < active.size();) {
+            if (active[i]->end <= current.start) {
+                regFree[locations[active[i]->vreg].reg] = true;
+                active.erase(active.begin() + i);
+            } else {
+                i++;
+            }
+        }
+        for (size_t i = 0; i < spilled.size();) {
+            if (spilled[i]->end <= current.start) {
+                frame.releaseTemporary(locations[spilled[i]->vreg].slot, spilled[i]->end);
+                spilled.erase(spilled.begin() + i);
+            } else {
+                i++;
+            }
+        }
+
+        int reg = takeRegister(current);
+        if (reg < 0) {
+            // 寄存器耗尽：溢出结束最晚的区间
+            LiveInterval* victim = nullptr;
+            for (auto* interval : active) {
+                int victimReg = locations[interval->vreg].reg;
+                if ((!current.crossesCall || isCalleeSaved(victimReg)) &&
+                    (!victim || interval->end > victim->end)) {
+                    victim = interval;
+                }
+            }
+            LiveInterval* spill = &current;
+            if (victim && victim->end > current.end) {
+                reg = locations[victim->vreg].reg;
+                locations[victim->vreg].reg = -1;
+                active.erase(std::find(active.begin(), active.end(), victim));
+                spill = victim;
+            }
+            // 换出的区间从它自己的起点就已活跃，槽位要在整个区间内空闲
+            locations[spill->vreg].slot = frame.allocateTemporary(spill->start);
+            spilled.push_back(spill);
+            if (reg < 0) {
+                continue;
+            }
+        }
+
+        regFree[reg] = false;
+        locations[current.vreg].reg = reg;
+        active.push_back(&current);
+        if (isCalleeSaved(reg)) {
+            calleeSavedTouched[reg] = true;
+        }
+    }
+
+    for (int reg : kCalleeSaved) {
+        if (calleeSavedTouched[reg]) {
+            calleeSavedUsed.push_back(reg);
+        }
+    }
+}
@@ -0,0 +1,77 @@
+#ifndef REGALLOC_H
+#define REGALLOC_H
+
+#include "ir.h"
+#include <utility>
+#include <vector>
+
+// x86-64 物理寄存器编号
+enum PhysReg {
+    RAX, RCX, RDX, RBX, RSI, RDI, R8, R9, R10, R11, R12, R13, R14, R15,
+    PHYS_REG_COUNT
+};
+
+const char* regName64(int reg);
+const char* regName32(int reg);
+const char* regName8(int reg);
+
+// 函数栈帧布局：固定槽位 + 可复用的临时槽位
+// 偏移均为相对%rbp的正数（地址为 -offset(%rbp)）
+class FrameLayout {
+private:
+    int allocatedSize;                  // 已分配的字节数
+    std::vector<std::pair<int, int>> freeTemporaries;   // 已释放的临时槽位：(偏移, 空闲的起始位置)
+
+public:
+    FrameLayout() : allocatedSize(0) {}
+
+    int allocateLocal();                // 分配整个函数期间都占用的槽位
+    int allocateTemporary(int from);    // 分配从位置from起空闲的临时槽位，优先复用已释放的槽位
+    void releaseTemporary(int offset, int freeFrom);  // 临时值不再活跃时归还槽位，从freeFrom起可复用
+    int frameSize() const;              // 按16字节对齐后的栈帧大小
+    void reset();
+};
+
+// 虚拟寄存器的存放位置
+struct VRegLocation {
+    int reg;            // 物理寄存器，未分配寄存器时为-1
+    int slot;           // 溢出栈槽偏移（reg < 0 时有效）
+    bool isConstant;    // 只被一条const定义，直接作为立即数使用
+    int value;          // 常量值
+
+    VRegLocation() : reg(-1), slot(0), isConstant(false), value(0) {}
+};
+
+// 线性扫描寄存器分配
+// 活跃区间由CFG上的活跃变量分析得到；跨越调用的区间只能使用被调用者保存寄存器。
+// %rax、%rdx、%r11 保留给指令选择作临时寄存器，不参与分配。
+class RegisterAllocator {
+private:
+    struct LiveInterval {
+        int vreg;
+        int start;
+        int end;
+        bool crossesCall;
+    };
+
+    const IRFunction& function;
+    FrameLayout& frame;
+    std::vector<VRegLocation> locations;
+    std::vector<int> calleeSavedUsed;
+    std::vector<LiveInterval> intervals;
+    std::vector<int> callPositions;
+
+    void findConstants();
+    void buildIntervals();
+    void linearScan();
+
+public:
+    RegisterAllocator(const IRFunction& func, FrameLayout& layout);
+
+    void run();
+
+    const VRegLocation& location(int vreg) const { return locations[vreg]; }
+    const std::vector<int>& usedCalleeSavedRegisters() const { return calleeSavedUsed; }
+};
+
+#endif // REGALLOC_H
@@ -0,0 +1,429 @@
+#include "ast.h"
+#include "scanner.h"
+#include "parser.tab.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+
+#if defined(__GNUC__) && defined(__SSE2__)
+#include <immintrin.h>
+#define SCANNER_X86 1
+#define SCANNER_AVX2 __attribute__((target("avx2")))
+#endif
+
+// lexer.l 中的Flex入口（可重入扫描器，scanner为yyscan_t）
+int flex_lex(YYSTYPE* value, void* scanner);
+void* flex_begin(SourceBuffer& source, Diagnostics* diagnostics);
+const char* flex_text(void* scanner);
+int flex_length(void* scanner);
+int flex_line(void* scanner);
+void flex_end(void* scanner);
+
+namespace {
+
+// 与lexer.l中字符类一致的逐字节判断
+inline bool isIdentChar(unsigned char c) {
+    return c == '_' || static_cast<unsigned>((c | 0x20) - 'a') < 26u || static_cast<unsigned>(c - '0') < 10u;
+}
+
+inline bool isDigitChar(unsigned char c) {
+    return static_cast<unsigned>(c - '0') < 10u;
+}
+
+inline bool isBlankChar(unsigned char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+inline int lowestBit(uint32_t mask) {
+#ifdef __GNUC__
+    return __builtin_ctz(mask);
+#else
+    int i = 0;
+    while (!(mask & 1u)) { mask >>= 1; i++; }
+    return i;
+#endif
+}
+
+inline int countBits(uint32_t mask) {
+#ifdef __GNUC__
+    return __builtin_popcount(mask);
+#else
+    int n = 0;
+    for (; mask; mask &= mask - 1) n++;
+    return n;
+#endif
+}
+
+// 每种宽度提供同样的分类函数：返回从p开始width个字节中满足条件的位掩码
+struct Scalar {
+    static const int width = 1;
+    static const uint32_t all = 1;
+    static uint32_t ident(const char* p) { return isIdentChar(*p); }
+    static uint32_t digit(const char* p) { return isDigitChar(*p); }
+    static uint32_t blank(const char* p) { return isBlankChar(*p); }
+    static uint32_t equal(const char* p, char c) { return *p == c; }
+};
+
+#ifdef SCANNER_X86
+struct Sse2 {
+    static const int width = 16;
+    static const uint32_t all = 0xFFFF;
+
+    static __m128i load(const char* p) {
+        return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    }
+    // lo <= v <= hi（有符号比较，非ASCII字节为负，总在范围外）
+    static __m128i inRange(__m128i v, char lo, char hi) {
+        return _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8(lo - 1)),
+                             _mm_cmplt_epi8(v, _mm_set1_epi8(hi + 1)));
+    }
+    static uint32_t ident(const char* p) {
+        __m128i v = load(p);
+        __m128i letter = inRange(_mm_or_si128(v, _mm_set1_epi8(0x20)), 'a', 'z');
+        __m128i under = _mm_cmpeq_epi8(v, _mm_set1_epi8('_'));
+        return _mm_movemask_epi8(_mm_or_si128(_mm_or_si128(letter, under), inRange(v, '0', '9')));
+    }
+    static uint32_t digit(const char* p) {
+        return _mm_movemask_epi8(inRange(load(p), '0', '9'));
+    }
+    static uint32_t blank(const char* p) {
+        __m128i v = load(p);
+        __m128i space = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\t')));
+        __m128i line = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\r')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\n')));
+        return _mm_movemask_epi8(_mm_or_si128(space, line));
+    }
+    static uint32_t equal(const char* p, char c) {
+        return _mm_movemask_epi8(_mm_cmpeq_epi8(load(p), _mm_set1_epi8(c)));
+    }
+};
+
+// AVX2版本只在运行时检测到支持时使用；这些函数按avx2目标单独编译，不会内联进通用代码
+struct Avx2 {
+    static const int width = 32;
+    static const uint32_t all = 0xFFFFFFFFu;
+
+    SCANNER_AVX2 static __m256i load(const char* p) {
+        return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    }
+    SCANNER_AVX2 static __m256i inRange(__m256i v, char lo, char hi) {
+        return _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8(lo - 1)),
+                                _mm256_cmpgt_epi8(_mm256_set1_epi8(hi + 1), v));
+    }
+    SCANNER_AVX2 static uint32_t ident(const char* p) {
+        __m256i v = load(p);
+        __m256i letter = inRange(_mm256_or_si256(v, _mm256_set1_epi8(0x20)), 'a', 'z');
+        __m256i under = _mm256_cmpeq_epi8(v, _mm256_set1_epi8('_'));
+        return _mm256_movemask_epi8(_mm256_or_si256(_mm256_or_si256(letter, under), inRange(v, '0', '9')));
+    }
+    SCANNER_AVX2 static uint32_t digit(const char* p) {
+        return _mm256_movemask_epi8(inRange(load(p), '0', '9'));
+    }
+    SCANNER_AVX2 static uint32_t blank(const char* p) {
+        __m256i v = load(p);
+        __m256i space = _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')),
+                                        _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t')));
+        __m256i line = _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r')),
+                                       _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n')));
+        return _mm256_movemask_epi8(_mm256_or_si256(space, line));
+    }
+    SCANNER_AVX2 static uint32_t equal(const char* p, char c) {
+        return _mm256_movemask_epi8(_mm256_cmpeq_epi8(load(p), _mm256_set1_epi8(c)));
+    }
+};
+#endif
+
+// 跳过满足条件的字符。整块读取只在块完全位于内容范围内时进行，尾部逐字节处理
+template<class V, uint32_t (*Mask)(const char*), bool (*Test)(unsigned char)>
+const char* skipClass(const char* p, const char* end) {
+    while (end - p >= V::width) {
+        uint32_t stop = ~Mask(p) & V::all;
+        if (stop) {
+            return p + lowestBit(stop);
+        }
+        p += V::width;
+    }
+    while (p < end && Test(*p)) {
+        p++;
+    }
+    return p;
+}
+
+// 跳过空白和换行，同时累计行号
+template<class V>
+const char* skipBlank(const char* p, const char* end, int& line) {
+    while (end - p >= V::width) {
+        uint32_t newlines = V::equal(p, '\n');
+        uint32_t stop = ~V::blank(p) & V::all;
+        if (stop) {
+            line += countBits(newlines & ((stop & (0u - stop)) - 1));
+            return p + lowestBit(stop);
+        }
+        line += countBits(newlines);
+        p += V::width;
+    }
+    for (; p < end && isBlankChar(*p); p++) {
+        line += *p == '\n';
+    }
+    return p;
+}
+
+// 查找字节c，找不到时返回end
+template<class V>
+const char* findByte(const char* p, const char* end, char c) {
+    while (end - p >= V::width) {
+        uint32_t found = V::equal(p, c);
+        if (found) {
+            return p + lowestBit(found);
+        }
+        p += V::width;
+    }
+    while (p < end && *p != c) {
+        p++;
+    }
+    return p;
+}
+
+// 从注释开头"/*"之后查找第一个"*/"，返回其后的位置并累计注释中的换行；
+// 未闭合时返回nullptr，此时与Flex一样只把'/'作为单独的Token
+template<class V>
+const char* skipBlockComment(const char* p, const char* end, int& line) {
+    int newlines = 0;
+    while (end - p >= V::width) {
+        uint32_t stars = V::equal(p, '*');
+        for (; stars; stars &= stars - 1) {
+            int i = lowestBit(stars);
+            if (p + i + 1 < end && p[i + 1] == '/') {
+                line += newlines + countBits(V::equal(p, '\n') & ((1u << i) - 1));
+                return p + i + 2;
+            }
+        }
+        newlines += countBits(V::equal(p, '\n'));
+        p += V::width;
+    }
+    for (; p < end; p++) {
+        if (*p == '*' && p + 1 < end && p[1] == '/') {
+            line += newlines;
+            return p + 2;
+        }
+        newlines += *p == '\n';
+    }
+    return nullptr;
+}
+
+int keywordToken(const char* s, size_t n) {
+    switch (n) {
+        case 2:
+            if (memcmp(s, "if", 2) == 0) return IF;
+            break;
+        case 3:
+            if (memcmp(s, "int", 3) == 0) return INT;
+            if (memcmp(s, "for", 3) == 0) return FOR;
+            break;
+        case 4:
+            if (memcmp(s, "char", 4) == 0) return CHAR;
+            if (memcmp(s, "void", 4) == 0) return VOID;
+            if (memcmp(s, "else", 4) == 0) return ELSE;
+            break;
+        case 5:
+            if (memcmp(s, "float", 5) == 0) return FLOAT;
+            if (memcmp(s, "while", 5) == 0) return WHILE;
+            if (memcmp(s, "break", 5) == 0) return BREAK;
+            break;
+        case 6:
+            if (memcmp(s, "double", 6) == 0) return DOUBLE;
+            if (memcmp(s, "return", 6) == 0) return RETURN;
+            break;
+        case 8:
+            if (memcmp(s, "continue", 8) == 0) return CONTINUE;
+            break;
+    }
+    return 0;
+}
+
+int pairToken(unsigned char c, unsigned char n) {
+    switch (c) {
+        case '=': return n == '=' ? EQ : 0;
+        case '!': return n == '=' ? NE : 0;
+        case '<': return n == '=' ? LE : 0;
+        case '>': return n == '=' ? GE : 0;
+        case '&': return n == '&' ? AND : 0;
+        case '|': return n == '|' ? OR : 0;
+        case '+': return n == '+' ? INC : 0;
+        case '-': return n == '-' ? DEC : 0;
+    }
+    return 0;
+}
+
+// 对应lexer.l中"."规则的错误信息
+void reportInvalid(Diagnostics& diagnostics, char c, int line) {
+    if (c == '"') {
+        diagnostics.report(stdout, "[词法错误] 行 %d: 不支持的字符串字面量 '%c'，当前编译器不支持字符串类型\n", line, c);
+    } else if (c == '\'') {
+        diagnostics.report(stdout, "[词法错误] 行 %d: 不支持的字符字面量 '%c'，当前编译器不支持字符字面量\n", line, c);
+    } else if (c >= 32 && c <= 126) {
+        diagnostics.report(stdout, "[词法错误] 行 %d: 无效字符 '%c' (ASCII %d)，不在词法规则范围内\n", line, c, c);
+    } else {
+        diagnostics.report(stdout, "[词法错误] 行 %d: 无效字符 (ASCII %d)，不可打印字符\n", line, c);
+    }
+}
+
+template<class V>
+int scanToken(SimdScanner::State& state, const char*& start, TokenValue& value) {
+    const char* p = state.cursor;
+    const char* end = state.end;
+    for (;;) {
+        p = skipBlank<V>(p, end, state.line);
+        start = p;
+        if (p >= end) {
+            state.cursor = p;
+            return 0;
+        }
+        unsigned char c = *p;
+        unsigned char n = p + 1 < end ? p[1] : 0;
+
+        if (isIdentChar(c) && !isDigitChar(c)) {
+            p = skipClass<V, V::ident, isIdentChar>(p + 1, end);
+            state.cursor = p;
+            int keyword = keywordToken(start, p - start);
+            if (keyword) {
+                return keyword;
+            }
+            value.name = Name::intern(start, p - start);
+            return IDENTIFIER;
+        }
+        if (isDigitChar(c)) {
+            state.cursor = skipClass<V, V::digit, isDigitChar>(p + 1, end);
+            value.intval = atoi(start);  // 数字串之后必有非数字字节（至少是末尾的'\0'）
+            return INTEGER_LITERAL;
+        }
+        if (c == '/' && n == '/') {
+            p = findByte<V>(p + 2, end, '\n');
+            continue;
+        }
+        if (c == '/' && n == '*') {
+            const char* close = skipBlockComment<V>(p + 2, end, state.line);
+            if (close) {
+                p = close;
+                continue;
+            }
+        }
+        if (int pair = pairToken(c, n)) {
+            state.cursor = p + 2;
+            return pair;
+        }
+        state.cursor = p + 1;
+        if (c != 0 && strchr("+-*/%=<>!(){}[];,", c)) {
+            return c;
+        }
+        reportInvalid(*state.diagnostics, static_cast<char>(c), state.line);
+        return ERROR_TOKEN;
+    }
+}
+
+} // namespace
+
+SimdScanner::SimdScanner(SourceBuffer& source, Diagnostics& diagnostics) : base(source.data()) {
+    state.cursor = base;
+    state.end = base + source.size();
+    state.line = 1;
+    state.diagnostics = &diagnostics;
+#ifdef SCANNER_X86
+    scan = __builtin_cpu_supports("avx2") ? scanToken<Avx2> : scanToken<Sse2>;
+#else
+    scan = scanToken<Scalar>;
+#endif
+}
+
+int SimdScanner::next(TokenView& token, TokenValue& value) {
+    const char* start;
+    token.kind = scan(state, start, value);
+    token.line = state.line;
+    token.offset = static_cast<uint32_t>(start - base);
+    token.length = static_cast<uint32_t>(state.cursor - start);
+    return token.kind;
+}
+
+Lexer::Lexer(Diagnostics& diagnostics)
+    : diagnostics(diagnostics), flex(nullptr), flexBase(nullptr), replayBuffer(nullptr), replayIndex(0) {
+    last.kind = 0;
+    last.line = 1;
+    last.offset = 0;
+    last.length = 0;
+    lastValue.intval = 0;
+}
+
+Lexer::~Lexer() {
+    end();
+}
+
+bool Lexer::begin(SourceBuffer& source, ScannerKind kind) {
+    end();
+    last.line = 1;
+    if (kind == ScannerKind::Simd) {
+        simd.reset(new SimdScanner(source, diagnostics));
+        return true;
+    }
+    flexBase = source.data();
+    flex = flex_begin(source, &diagnostics);
+    return flex != nullptr;
+}
+
+void Lexer::replay(const TokenBuffer& buffer) {
+    end();
+    last.line = 1;
+    replayBuffer = &buffer;
+    replayIndex = 0;
+}
+
+void Lexer::end() {
+    simd.reset();
+    if (flex) {
+        flex_end(flex);
+        flex = nullptr;
+    }
+    replayBuffer = nullptr;
+}
+
+void Lexer::record(TokenBuffer& buffer) const {
+    buffer.tokens.push_back(last);
+    buffer.values.push_back(lastValue);
+}
+
+int Lexer::next() {
+    if (replayBuffer) {
+        // 缓冲区读完（词法分析在错误处提前停止）后一律返回文件结束
+        if (replayIndex >= replayBuffer->tokens.size()) {
+            last.kind = 0;
+            return 0;
+        }
+        last = replayBuffer->tokens[replayIndex];
+        lastValue = replayBuffer->values[replayIndex++];
+        return last.kind;
+    }
+    if (simd) {
+        return simd->next(last, lastValue);
+    }
+    YYSTYPE value;
+    int kind = flex_lex(&value, flex);
+    last.kind = kind;
+    last.line = flex_line(flex);
+    last.offset = static_cast<uint32_t>(flex_text(flex) - flexBase);
+    last.length = static_cast<uint32_t>(flex_length(flex));
+    if (kind == IDENTIFIER) {
+        lastValue.name = value.name;
+    } else {
+        lastValue.intval = kind == INTEGER_LITERAL ? value.intval : 0;
+    }
+    return kind;
+}
+
+int Lexer::next(YYSTYPE& value) {
+    int kind = next();
+    if (kind == IDENTIFIER) {
+        value.name = lastValue.name;
+    } else if (kind == INTEGER_LITERAL) {
+        value.intval = lastValue.intval;
+    }
+    return kind;
+}
@@ -0,0 +1,84 @@
+#ifndef SCANNER_H
+#define SCANNER_H
+
+#include "diagnostics.h"
+#include "intern.h"
+#include "source.h"
+#include <vector>
+
+union YYSTYPE;
+
+// 词法分析器实现
+enum class ScannerKind {
+    Flex,   // lexer.l 生成的DFA
+    Simd    // 手写扫描器
+};
+
+// Token的语义值（对应yylval中标识符和整数字面量两种取值）
+union TokenValue {
+    int intval;
+    Name name;
+};
+
+// Token缓冲：一次词法分析的结果，之后可原样重放给语法分析器，
+// 使各阶段共用同一次扫描。词素不复制，位置引用源文件缓冲区
+struct TokenBuffer {
+    std::vector<TokenView> tokens;
+    std::vector<TokenValue> values;
+};
+
+// 手写词法分析器：规则与lexer.l逐条对应，产生相同的Token序列和行号。
+// 空白、标识符、数字和注释按16字节（SSE2）或32字节（AVX2，运行时检测）
+// 一次分类跳过；其他平台退化为逐字节扫描。
+class SimdScanner {
+public:
+    struct State {
+        const char* cursor;
+        const char* end;
+        int line;
+        Diagnostics* diagnostics;   // 词法错误信息的去向
+    };
+
+private:
+    const char* base;
+    State state;
+    int (*scan)(State& state, const char*& start, TokenValue& value);  // 按指令集选定的扫描函数
+
+public:
+    SimdScanner(SourceBuffer& source, Diagnostics& diagnostics);
+
+    // 返回下一个Token的种类（0为文件结束），并填写其位置和语义值
+    int next(TokenView& token, TokenValue& value);
+};
+
+// 词法分析前端：按选定的实现逐个产生Token，或重放Token缓冲。
+// 状态全部在对象内（Flex也使用可重入扫描器），每次编译各用一个，可在不同线程中同时工作
+class Lexer {
+private:
+    Diagnostics& diagnostics;
+    std::unique_ptr<SimdScanner> simd;  // 选用手写扫描器时非空
+    void* flex;                         // Flex扫描器（yyscan_t）
+    const char* flexBase;               // Flex正在扫描的缓冲区起点
+    const TokenBuffer* replayBuffer;    // 重放中的Token缓冲
+    size_t replayIndex;
+    TokenView last;                     // 最近一次返回的Token
+    TokenValue lastValue;
+
+public:
+    explicit Lexer(Diagnostics& diagnostics);
+    ~Lexer();
+    Lexer(const Lexer&) = delete;
+    Lexer& operator=(const Lexer&) = delete;
+
+    bool begin(SourceBuffer& source, ScannerKind kind);
+    void replay(const TokenBuffer& buffer);  // 之后的 next() 依次返回缓冲区中的Token
+    void end();
+
+    int next();                     // 返回下一个Token的种类（0为文件结束）
+    int next(YYSTYPE& value);       // 供语法分析器调用：同时填写yylval
+    const TokenView& token() const { return last; }
+    int line() const { return last.line; }  // 对应Flex的yylineno
+    void record(TokenBuffer& buffer) const; // 把最近一次的Token及其语义值追加到缓冲区
+};
+
+#endif // SCANNER_H
@@ -3,68 +3,106 @@
 #include <iomanip>
 
 // SymbolTable 实现
-SymbolTable::SymbolTable() : currentScope(-1) {
+SymbolTable::SymbolTable() : slots(64, Slot{0, -1}), used(0), currentScope(-1), declared(0) {
     enterScope(); // 进入全局作用域
 }
 
+SymbolTable::Slot& SymbolTable::find(Name name) {
+    size_t mask = slots.size() - 1;
+    size_t i = (name.index() * 0x9E3779B1u) & mask;
+    while (slots[i].name != 0 && slots[i].name != name.index()) {
+        i = (i + 1) & mask;
+    }
+    return slots[i];
+}
+
+void SymbolTable::grow() {
+    std::vector<Slot> old(slots.size() * 2, Slot{0, -1});
+    old.swap(slots);
+    for (const Slot& slot : old) {
+        if (slot.name != 0) {
+            size_t mask = slots.size() - 1;
+            size_t i = (slot.name * 0x9E3779B1u) & mask;
+            while (slots[i].name != 0) {
+                i = (i + 1) & mask;
+            }
+            slots[i] = slot;
+        }
+    }
+}
+
 void SymbolTable::enterScope() {
-    scopes.emplace_back();
+    scopeMarks.push_back(symbols.size());
     currentScope++;
 }
 
 void SymbolTable::exitScope() {
     if (currentScope > 0) {
-        scopes.pop_back();
+        // 按声明的逆序撤销本层符号，链头退回被遮蔽的外层符号
+        size_t mark = scopeMarks.back();
+        while (symbols.size() > mark) {
+            const SymbolInfo& symbol = symbols.back();
+            find(symbol.name).head = symbol.shadowed;
+            symbols.pop_back();
+        }
+        scopeMarks.pop_back();
         currentScope--;
     }
 }
 
-bool SymbolTable::declare(const std::string& name, const std::string& type, const std::string& kind) {
+bool SymbolTable::declare(Name name, TypeId type, SymbolKind kind, int frameSlot) {
     // 检查当前作用域是否已有同名符号
     if (lookupInCurrentScope(name) != nullptr) {
         return false; // 重复声明
     }
     
-    scopes[currentScope][name] = std::unique_ptr<SymbolInfo>(new SymbolInfo(name, type, kind, currentScope));
+    Slot* slot = &find(name);
+    if (slot->name == 0) {
+        // 负载超过一半时扩容，保证探测序列较短
+        if ((used + 1) * 2 > slots.size()) {
+            grow();
+            slot = &find(name);
+        }
+        slot->name = name.index();
+        used++;
+    }
+    symbols.emplace_back(name, type, kind, currentScope);
+    symbols.back().shadowed = slot->head;
+    symbols.back().id = declared++;
+    symbols.back().slot = frameSlot;
+    slot->head = static_cast<int>(symbols.size() - 1);
     return true;
 }
 
-SymbolInfo* SymbolTable::lookup(const std::string& name) {
-    // 从当前作用域向外查找
-    for (int i = currentScope; i >= 0; i--) {
-        auto it = scopes[i].find(name);
-        if (it != scopes[i].end()) {
-            return it->second.get();
-        }
-    }
-    return nullptr;
+SymbolInfo* SymbolTable::lookup(Name name) {
+    int head = find(name).head;
+    return head >= 0 ? &symbols[head] : nullptr;
 }
 
-SymbolInfo* SymbolTable::lookupInCurrentScope(const std::string& name) {
-    if (currentScope >= 0) {
-        auto it = scopes[currentScope].find(name);
-        if (it != scopes[currentScope].end()) {
-            return it->second.get();
-        }
+SymbolInfo* SymbolTable::lookupInCurrentScope(Name name) {
+    SymbolInfo* symbol = lookup(name);
+    if (symbol != nullptr && symbol->scopeLevel == currentScope) {
+        return symbol;
     }
     return nullptr;
 }
 
 void SymbolTable::print() const {
     std::cout << "\n=== 符号表信息 ===" << std::endl;
+    size_t next = 0;
     for (int scope = 0; scope <= currentScope; scope++) {
         std::cout << "作用域 " << scope << ":" << std::endl;
         std::cout << std::setw(15) << "符号名" << std::setw(10) << "类型" 
                   << std::setw(12) << "种类" << std::setw(12) << "已初始化" << std::endl;
         std::cout << std::string(50, '-') << std::endl;
         
-        for (const auto& pair : scopes[scope]) {
-            const auto& name = pair.first;
-            const auto& symbol = pair.second;
-            std::cout << std::setw(15) << symbol->name 
-                      << std::setw(10) << symbol->type
-                      << std::setw(12) << symbol->kind
-                      << std::setw(12) << (symbol->isInitialized ? "是" : "否") << std::endl;
+        size_t end = scope < currentScope ? scopeMarks[scope + 1] : symbols.size();
+        for (; next < end; next++) {
+            const SymbolInfo& symbol = symbols[next];
+            std::cout << std::setw(15) << symbol.name 
+                      << std::setw(10) << symbol.type
+                      << std::setw(12) << symbol.kind
+                      << std::setw(12) << (symbol.isInitialized ? "是" : "否") << std::endl;
         }
         std::cout << std::endl;
     }
@@ -81,6 +119,9 @@ bool SemanticAnalyzer::analyze(Program* program, bool silent) {
         std::cout << "开始语义分析..." << std::endl;
     }
     
+    // 折叠生成的节点与语法树分配在同一内存池中
+    folder.setArena(program->arena);
+    
     // 访问程序根节点
     program->accept(this);
     
@@ -144,126 +185,120 @@ void SemanticAnalyzer::addWarning(const std::string& message) {
     warnings.push_back(message);
 }
 
-TypeInfo SemanticAnalyzer::getExpressionType(Expression* expr) {
-    TypeInfo oldType = currentExpressionType;
-    expr->accept(this);
-    TypeInfo result = currentExpressionType;
-    currentExpressionType = oldType;
-    return result;
+TypeId SemanticAnalyzer::analyzeExpression(Expression*& slot) {
+    // 每个表达式节点只访问一次，结果类型记在节点上（出错时保持None）
+    slot->accept(this);
+    TypeId type = slot->semanticInfo.type;
+    // 子表达式先于父表达式完成分析，折叠自底向上进行；已有错误时保留原树
+    if (foldConstants && type.isValid() && errors.empty()) {
+        slot = folder.fold(slot, type);
+    }
+    return type;
 }
 
-bool SemanticAnalyzer::isValidBinaryOperation(const std::string& op, const TypeInfo& left, const TypeInfo& right) {
-    if (!left.isValid || !right.isValid) return false;
-    
-    if (op == "+" || op == "-" || op == "*" || op == "/" || op == "%") {
-        return left.isNumeric() && right.isNumeric();
-    } else if (op == "==" || op == "!=" || op == "<" || op == ">" || op == "<=" || op == ">=") {
-        return left.isNumeric() && right.isNumeric();
-    } else if (op == "&&" || op == "||") {
-        return true; // 任何类型都可以用于逻辑运算
+bool SemanticAnalyzer::isValidBinaryOperation(BinaryOp op, TypeId left, TypeId right) {
+    if (!left.isValid() || !right.isValid()) return false;
+    
+    switch (op) {
+        case BinaryOp::Add: case BinaryOp::Sub: case BinaryOp::Mul:
+        case BinaryOp::Div: case BinaryOp::Mod:
+            return left.isNumeric() && right.isNumeric();
+        case BinaryOp::Eq: case BinaryOp::Ne: case BinaryOp::Lt:
+        case BinaryOp::Gt: case BinaryOp::Le: case BinaryOp::Ge:
+            return left.isNumeric() && right.isNumeric();
+        case BinaryOp::LogicalAnd: case BinaryOp::LogicalOr:
+            return true; // 任何类型都可以用于逻辑运算
+        default:
+            return false;
     }
-    
-    return false;
 }
 
-bool SemanticAnalyzer::isValidUnaryOperation(const std::string& op, const TypeInfo& operand) {
-    if (!operand.isValid) return false;
+bool SemanticAnalyzer::isValidUnaryOperation(UnaryOp op, TypeId operand) {
+    if (!operand.isValid()) return false;
     
-    if (op == "-" || op == "+") {
+    if (op == UnaryOp::Neg) {
         return operand.isNumeric();
-    } else if (op == "!") {
-        return true; // 任何类型都可以用于逻辑非运算
     }
-    
-    return false;
+    return true; // 任何类型都可以用于逻辑非运算
 }
 
-std::string SemanticAnalyzer::getResultType(const std::string& op, const TypeInfo& left, const TypeInfo& right) {
-    if (op == "==" || op == "!=" || op == "<" || op == ">" || op == "<=" || op == ">=" ||
-        op == "&&" || op == "||") {
-        return "int"; // 比较和逻辑运算返回整型
+TypeId SemanticAnalyzer::getResultType(BinaryOp op, TypeId left, TypeId right) {
+    if (isComparison(op) || isLogical(op)) {
+        return TypeKind::Int; // 比较和逻辑运算返回整型
     }
     
     // 算术运算的类型提升规则
-    if (left.baseType == "double" || right.baseType == "double") return "double";
-    if (left.baseType == "float" || right.baseType == "float") return "float";
-    return "int";
+    if (left == TypeKind::Double || right == TypeKind::Double) return TypeKind::Double;
+    if (left == TypeKind::Float || right == TypeKind::Float) return TypeKind::Float;
+    return TypeKind::Int;
 }
 
 // 访问者模式实现
 void SemanticAnalyzer::visit(IntegerLiteral* node) {
-    currentExpressionType = TypeInfo("int");
-    
     // 填充语义信息
-    node->semanticInfo.type = "int";
-    node->semanticInfo.symbolKind = "literal";
+    node->semanticInfo.type = TypeKind::Int;
+    node->semanticInfo.symbolKind = SymbolKind::Literal;
     node->semanticInfo.isInitialized = true;
 }
 
 void SemanticAnalyzer::visit(Identifier* node) {
     currentLine = node->lineNumber;
-    setCurrentContext("标识符 '" + node->name + "'");
+    setCurrentContext("标识符 '" + node->name.str() + "'");
     
     SymbolInfo* symbol = symbolTable.lookup(node->name);
     if (!symbol) {
-        addError("未声明的标识符 '" + node->name + "'", "未声明错误", "标识符使用");
-        currentExpressionType = TypeInfo("", false);
-        
+        addError("未声明的标识符 '" + node->name.str() + "'", "未声明错误", "标识符使用");
         // 填充错误的语义信息
-        node->semanticInfo.hasSemanticError = true;
-        node->semanticInfo.errorMessage = "未声明的标识符";
+        node->semanticInfo.error = NodeError::UndeclaredIdentifier;
         return;
     }
     
-    if (symbol->kind == "variable" && !symbol->isInitialized) {
-        addWarning("使用了未初始化的变量 '" + node->name + "'");
+    if (symbol->kind == SymbolKind::Variable && !symbol->isInitialized) {
+        addWarning("使用了未初始化的变量 '" + node->name.str() + "'");
     }
     
-    currentExpressionType = TypeInfo(symbol->type);
-    
     // 填充语义信息
     node->semanticInfo.type = symbol->type;
     node->semanticInfo.symbolKind = symbol->kind;
     node->semanticInfo.isInitialized = symbol->isInitialized;
-    node->semanticInfo.scopeLevel = symbol->scopeLevel;
+    node->semanticInfo.scopeLevel = static_cast<uint16_t>(symbol->scopeLevel);
+    node->binding.symbol = symbol->id;
+    node->binding.slot = symbol->slot;
 }
 
 void SemanticAnalyzer::visit(BinaryExpression* node) {
     currentLine = node->lineNumber;
-    setCurrentContext("二元表达式 '" + node->op + "'");
+    setCurrentContext("二元表达式 '" + opSpelling(node->op) + "'");
     
-    TypeInfo leftType = getExpressionType(node->left.get());
-    TypeInfo rightType = getExpressionType(node->right.get());
+    TypeId leftType = analyzeExpression(node->left);
+    TypeId rightType = analyzeExpression(node->right);
     
     if (!isValidBinaryOperation(node->op, leftType, rightType)) {
-        addError("无效的二元运算: " + leftType.baseType + " " + node->op + " " + rightType.baseType, "类型错误", "二元运算表达式");
-        currentExpressionType = TypeInfo("", false);
-        
+        addError("无效的二元运算: " + leftType.name() + " " + opSpelling(node->op) + " " + rightType.name(), "类型错误", "二元运算表达式");
         // 填充错误的语义信息
-        node->semanticInfo.hasSemanticError = true;
-        node->semanticInfo.errorMessage = "无效的二元运算";
+        node->semanticInfo.error = NodeError::InvalidBinaryOperation;
         return;
     }
     
-    std::string resultType = getResultType(node->op, leftType, rightType);
-    currentExpressionType = TypeInfo(resultType);
+    TypeId resultType = getResultType(node->op, leftType, rightType);
     
     // 填充语义信息
     node->semanticInfo.type = resultType;
-    node->semanticInfo.symbolKind = "expression";
+    node->semanticInfo.symbolKind = SymbolKind::Expression;
     node->semanticInfo.isInitialized = true;
 }
 
 void SemanticAnalyzer::visit(UnaryExpression* node) {
-    TypeInfo operandType = getExpressionType(node->operand.get());
+    TypeId operandType = analyzeExpression(node->operand);
     
     if (!isValidUnaryOperation(node->op, operandType)) {
-        addError("无效的一元运算: " + node->op + operandType.baseType);
-        currentExpressionType = TypeInfo("", false);
+        addError("无效的一元运算: " + opSpelling(node->op) + operandType.name());
         return;
     }
     
-    currentExpressionType = operandType;
+    node->semanticInfo.type = operandType;
+    node->semanticInfo.symbolKind = SymbolKind::Expression;
+    node->semanticInfo.isInitialized = true;
 }
 
 void SemanticAnalyzer::visit(AssignmentExpression* node) {
@@ -273,56 +308,70 @@ void SemanticAnalyzer::visit(AssignmentExpression* node) {
     // 检查左值是否已声明
     SymbolInfo* symbol = symbolTable.lookup(node->left->name);
     if (!symbol) {
-        addError("未声明的变量 '" + node->left->name + "'", "未声明错误", "赋值表达式左值");
-        currentExpressionType = TypeInfo("", false);
+        addError("未声明的变量 '" + node->left->name.str() + "'", "未声明错误", "赋值表达式左值");
         return;
     }
     
-    if (symbol->kind != "variable" && symbol->kind != "parameter") {
-        addError("不能给非变量 '" + node->left->name + "' 赋值", "赋值错误", "赋值表达式");
-        currentExpressionType = TypeInfo("", false);
+    if (symbol->kind != SymbolKind::Variable && symbol->kind != SymbolKind::Parameter) {
+        addError("不能给非变量 '" + node->left->name.str() + "' 赋值", "赋值错误", "赋值表达式");
         return;
     }
     
     // 检查右值类型
-    TypeInfo rightType = getExpressionType(node->right.get());
-    TypeInfo leftType(symbol->type);
+    TypeId rightType = analyzeExpression(node->right);
+    TypeId leftType = symbol->type;
     
     if (!rightType.canAssignTo(leftType)) {
-        addError("类型不匹配: 不能将 " + rightType.baseType + " 赋值给 " + leftType.baseType, "类型错误", "赋值表达式");
-        currentExpressionType = TypeInfo("", false);
+        addError("类型不匹配: 不能将 " + rightType.name() + " 赋值给 " + leftType.name(), "类型错误", "赋值表达式");
         return;
     }
     
     // 标记变量已初始化
     symbol->isInitialized = true;
-    currentExpressionType = leftType;
+    
+    // 填充语义信息：左值按被赋值的变量填写，赋值表达式的值为左值类型
+    Identifier* target = node->left;
+    target->semanticInfo.type = leftType;
+    target->semanticInfo.symbolKind = symbol->kind;
+    target->semanticInfo.isInitialized = true;
+    target->semanticInfo.scopeLevel = static_cast<uint16_t>(symbol->scopeLevel);
+    target->binding.symbol = symbol->id;
+    target->binding.slot = symbol->slot;
+    node->semanticInfo.type = leftType;
+    node->semanticInfo.symbolKind = SymbolKind::Expression;
+    node->semanticInfo.isInitialized = true;
 }
 
 void SemanticAnalyzer::visit(FunctionCall* node) {
     currentLine = node->lineNumber;
-    setCurrentContext("函数调用 '" + node->name + "'");
+    setCurrentContext("函数调用 '" + node->name.str() + "'");
     
     SymbolInfo* symbol = symbolTable.lookup(node->name);
     if (!symbol) {
-        addError("未声明的函数 '" + node->name + "'", "未声明错误", "函数调用");
-        currentExpressionType = TypeInfo("", false);
-        return;
+        addError("未声明的函数 '" + node->name.str() + "'", "未声明错误", "函数调用");
+    } else if (symbol->kind != SymbolKind::Function) {
+        addError("'" + node->name.str() + "' 不是函数", "类型错误", "函数调用");
+    }
+    
+    // 实参中的名字同样在此解析，代码生成不再查找
+    for (auto& arg : node->arguments) {
+        analyzeExpression(arg);
     }
     
-    if (symbol->kind != "function") {
-        addError("'" + node->name + "' 不是函数", "类型错误", "函数调用");
-        currentExpressionType = TypeInfo("", false);
+    if (!symbol || symbol->kind != SymbolKind::Function) {
         return;
     }
     
     // 假设函数调用类型正确
-    currentExpressionType = TypeInfo(symbol->type);
+    node->binding.symbol = symbol->id;
+    node->semanticInfo.type = symbol->type;
+    node->semanticInfo.symbolKind = SymbolKind::Expression;
+    node->semanticInfo.isInitialized = true;
 }
 
 void SemanticAnalyzer::visit(ExpressionStatement* node) {
     if (node->expression) {
-        node->expression->accept(this);
+        analyzeExpression(node->expression);
     }
 }
 
@@ -330,28 +379,37 @@ void SemanticAnalyzer::visit(VariableDeclaration* node) {
     currentLine = node->lineNumber;
     setCurrentContext("变量声明");
     
+    // 局部变量按声明顺序分配栈帧槽位（重复声明的名字同样占位，槽位号与下标一一对应）
+    int slot = -1;
+    if (symbolTable.getCurrentScopeLevel() > 0) {
+        slot = frameSize;
+        frameSize += node->names.size() + node->initDeclarators.size();
+    }
+    node->firstSlot = slot;
+    auto nextSlot = [&slot]() { return slot < 0 ? -1 : slot++; };
+    
     // 处理简单声明
     for (const auto& name : node->names) {
-        if (!symbolTable.declare(name, node->type, "variable")) {
-            addError("重复声明变量 '" + name + "'", "重复声明错误", "变量声明");
+        if (!symbolTable.declare(name, node->type, SymbolKind::Variable, nextSlot())) {
+            addError("重复声明变量 '" + name.str() + "'", "重复声明错误", "变量声明");
         }
     }
     
     // 处理带初始化的声明
-    for (const auto& pair : node->initDeclarators) {
+    for (auto& pair : node->initDeclarators) {
         const auto& name = pair.first;
-        const auto& expr = pair.second;
-        if (!symbolTable.declare(name, node->type, "variable")) {
-            addError("重复声明变量 '" + name + "'", "重复声明错误", "变量声明");
+        auto& expr = pair.second;
+        if (!symbolTable.declare(name, node->type, SymbolKind::Variable, nextSlot())) {
+            addError("重复声明变量 '" + name.str() + "'", "重复声明错误", "变量声明");
             continue;
         }
         
         if (expr) {
-            TypeInfo initType = getExpressionType(expr.get());
-            TypeInfo varType(node->type);
+            TypeId initType = analyzeExpression(expr);
+            TypeId varType = node->type;
             
             if (!initType.canAssignTo(varType)) {
-                addError("初始化类型不匹配: 不能将 " + initType.baseType + " 赋值给 " + varType.baseType, "类型错误", "变量初始化");
+                addError("初始化类型不匹配: 不能将 " + initType.name() + " 赋值给 " + varType.name(), "类型错误", "变量初始化");
             } else {
                 // 标记变量已初始化
                 SymbolInfo* symbol = symbolTable.lookup(name);
@@ -374,7 +432,7 @@ void SemanticAnalyzer::visit(CompoundStatement* node) {
 }
 
 void SemanticAnalyzer::visit(IfStatement* node) {
-    node->condition->accept(this);
+    analyzeExpression(node->condition);
     node->thenStmt->accept(this);
     if (node->elseStmt) {
         node->elseStmt->accept(this);
@@ -382,7 +440,7 @@ void SemanticAnalyzer::visit(IfStatement* node) {
 }
 
 void SemanticAnalyzer::visit(WhileStatement* node) {
-    node->condition->accept(this);
+    analyzeExpression(node->condition);
     node->body->accept(this);
 }
 
@@ -391,10 +449,10 @@ void SemanticAnalyzer::visit(ForStatement* node) {
         node->init->accept(this);
     }
     if (node->condition) {
-        node->condition->accept(this);
+        analyzeExpression(node->condition);
     }
     if (node->update) {
-        node->update->accept(this);
+        analyzeExpression(node->update);
     }
     node->body->accept(this);
 }
@@ -403,25 +461,25 @@ void SemanticAnalyzer::visit(ReturnStatement* node) {
     hasReturnStatement = true;
     
     if (node->value) {
-        TypeInfo returnType = getExpressionType(node->value.get());
-        TypeInfo expectedType(currentFunctionReturnType);
+        TypeId returnType = analyzeExpression(node->value);
+        TypeId expectedType = currentFunctionReturnType;
         
         if (!returnType.canAssignTo(expectedType)) {
-            addError("返回类型不匹配: 期望 " + expectedType.baseType + 
-                    ", 实际 " + returnType.baseType);
+            addError("返回类型不匹配: 期望 " + expectedType.name() + 
+                    ", 实际 " + returnType.name());
         }
-    } else if (currentFunctionReturnType != "void") {
+    } else if (currentFunctionReturnType != TypeKind::Void) {
         addError("非void函数必须返回值");
     }
 }
 
 void SemanticAnalyzer::visit(FunctionDefinition* node) {
     currentLine = node->lineNumber;
-    setCurrentContext("函数定义 '" + node->name + "'");
+    setCurrentContext("函数定义 '" + node->name.str() + "'");
     
     // 声明函数
-    if (!symbolTable.declare(node->name, node->returnType, "function")) {
-        addError("重复声明函数 '" + node->name + "'", "重复声明错误", "函数定义");
+    if (!symbolTable.declare(node->name, node->returnType, SymbolKind::Function)) {
+        addError("重复声明函数 '" + node->name.str() + "'", "重复声明错误", "函数定义");
     }
     
     // 进入函数作用域
@@ -429,12 +487,13 @@ void SemanticAnalyzer::visit(FunctionDefinition* node) {
     currentFunctionReturnType = node->returnType;
     hasReturnStatement = false;
     
-    // 声明参数
+    // 声明参数，依次占用栈帧的前几个槽位
+    frameSize = 0;
     for (const auto& param : node->parameters) {
         const auto& type = param.first;
         const auto& name = param.second;
-        if (!symbolTable.declare(name, type, "parameter")) {
-            addError("重复声明参数 '" + name + "'", "重复声明错误", "函数参数");
+        if (!symbolTable.declare(name, type, SymbolKind::Parameter, frameSize++)) {
+            addError("重复声明参数 '" + name.str() + "'", "重复声明错误", "函数参数");
         } else {
             // 参数默认已初始化
             SymbolInfo* symbol = symbolTable.lookup(name);
@@ -448,11 +507,12 @@ void SemanticAnalyzer::visit(FunctionDefinition* node) {
     node->body->accept(this);
     
     // 检查返回语句
-    if (node->returnType != "void" && !hasReturnStatement) {
-        addWarning("函数 '" + node->name + "' 可能没有返回值");
+    if (node->returnType != TypeKind::Void && !hasReturnStatement) {
+        addWarning("函数 '" + node->name.str() + "' 可能没有返回值");
     }
     
     // 退出函数作用域
+    node->frameSize = frameSize;
     symbolTable.exitScope();
 }
 
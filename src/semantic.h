@@ -2,28 +2,48 @@
 #define SEMANTIC_H
 
 #include "ast.h"
+#include "fold.h"
 #include <string>
-#include <unordered_map>
+#include <cstdint>
+#include <deque>
 #include <vector>
 #include <memory>
 
 // 符号信息结构
 struct SymbolInfo {
-    std::string name;
-    std::string type;
-    std::string kind; // "variable", "function", "parameter"
+    Name name;
+    TypeId type;
+    SymbolKind kind; // Variable, Function, Parameter
     int scopeLevel;
     bool isInitialized;
+    int shadowed;    // 被本符号遮蔽的同名外层符号（-1表示没有）
+    int id;          // 在整个程序中的声明序号
+    int slot;        // 栈帧槽位，非局部符号为-1
     
-    SymbolInfo(const std::string& n, const std::string& t, const std::string& k, int level = 0)
-        : name(n), type(t), kind(k), scopeLevel(level), isInitialized(false) {}
+    SymbolInfo(Name n, TypeId t, SymbolKind k, int level = 0)
+        : name(n), type(t), kind(k), scopeLevel(level), isInitialized(false), shadowed(-1), id(-1), slot(-1) {}
 };
 
-// 符号表类
+// 符号表类：所有作用域共用一张以驻留名编号为键的开放寻址表，
+// 每个名字指向其最内层的符号，同名的外层符号经 shadowed 串成链。
+// 符号按声明顺序压栈，栈本身即撤销日志：退出作用域时弹出到进入时的位置并恢复链头。
+// 查找与嵌套深度无关，进出作用域不分配内存
 class SymbolTable {
 private:
-    std::vector<std::unordered_map<std::string, std::unique_ptr<SymbolInfo>>> scopes;
+    struct Slot {
+        uint32_t name;   // 驻留名编号，0表示空槽
+        int head;        // 最内层符号在 symbols 中的下标，-1表示当前不可见
+    };
+
+    std::vector<Slot> slots;            // 容量为2的幂，线性探测，槽位只增不删
+    size_t used;                        // 已占用的槽位数
+    std::deque<SymbolInfo> symbols;     // 当前可见的全部符号（deque保证指针在压栈后仍有效）
+    std::vector<size_t> scopeMarks;     // 每层作用域进入时的 symbols 大小
     int currentScope;
+    int declared;                       // 已分配的声明序号数
+
+    Slot& find(Name name);
+    void grow();
 
 public:
     SymbolTable();
@@ -31,37 +51,13 @@ public:
     
     void enterScope();
     void exitScope();
-    bool declare(const std::string& name, const std::string& type, const std::string& kind);
-    SymbolInfo* lookup(const std::string& name);
-    SymbolInfo* lookupInCurrentScope(const std::string& name);
+    bool declare(Name name, TypeId type, SymbolKind kind, int frameSlot = -1);
+    SymbolInfo* lookup(Name name);
+    SymbolInfo* lookupInCurrentScope(Name name);
     void print() const;
     int getCurrentScopeLevel() const { return currentScope; }
 };
 
-// 类型信息结构
-struct TypeInfo {
-    std::string baseType;
-    bool isValid;
-    
-    TypeInfo(const std::string& type = "void", bool valid = true) 
-        : baseType(type), isValid(valid) {}
-        
-    bool isNumeric() const {
-        return baseType == "int" || baseType == "char" || baseType == "float" || baseType == "double";
-    }
-    
-    bool isInteger() const {
-        return baseType == "int" || baseType == "char";
-    }
-    
-    bool canAssignTo(const TypeInfo& target) const {
-        if (!isValid || !target.isValid) return false;
-        if (baseType == target.baseType) return true;
-        if (isNumeric() && target.isNumeric()) return true; // 允许数值类型间的隐式转换
-        return false;
-    }
-};
-
 // 语义错误类
 class SemanticError {
 public:
@@ -81,14 +77,16 @@ private:
     SymbolTable symbolTable;
     std::vector<SemanticError> errors;
     std::vector<std::string> warnings;
-    TypeInfo currentExpressionType;
-    std::string currentFunctionReturnType;
+    TypeId currentFunctionReturnType;
     bool hasReturnStatement;
     int currentLine;        // 当前行号
     std::string currentContext; // 当前上下文
+    ConstantFolder folder;      // 常量折叠与代数化简
+    bool foldConstants;         // 是否在分析时折叠表达式
+    int frameSize;              // 当前函数已分配的栈帧槽位数
 
 public:
-    SemanticAnalyzer() : hasReturnStatement(false), currentLine(0) {}
+    SemanticAnalyzer() : currentFunctionReturnType(TypeKind::Void), hasReturnStatement(false), currentLine(0), foldConstants(false), frameSize(0) {}
     ~SemanticAnalyzer() = default;
     
     // 主要分析函数
@@ -96,6 +94,7 @@ public:
     void printResults() const;
     void printSemanticTree(Program* program) const;
     bool hasErrors() const { return !errors.empty(); }
+    void enableFolding(bool enable) { foldConstants = enable; }
     
     // 访问者模式实现
     void visit(IntegerLiteral* node) override;
@@ -120,10 +119,10 @@ private:
     void addWarning(const std::string& message);
     void setCurrentLine(int line) { currentLine = line; }
     void setCurrentContext(const std::string& context) { currentContext = context; }
-    TypeInfo getExpressionType(Expression* expr);
-    bool isValidBinaryOperation(const std::string& op, const TypeInfo& left, const TypeInfo& right);
-    bool isValidUnaryOperation(const std::string& op, const TypeInfo& operand);
-    std::string getResultType(const std::string& op, const TypeInfo& left, const TypeInfo& right);
+    TypeId analyzeExpression(Expression*& slot);  // 分析并返回节点上记录的类型，随后原地折叠
+    bool isValidBinaryOperation(BinaryOp op, TypeId left, TypeId right);
+    bool isValidUnaryOperation(UnaryOp op, TypeId operand);
+    TypeId getResultType(BinaryOp op, TypeId left, TypeId right);
 };
 
 #endif 
\ No newline at end of file
@@ -0,0 +1,326 @@
+#include "server.h"
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <iostream>
+
+#ifndef _WIN32
+#include <csignal>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#ifndef _WIN32
+
+namespace {
+
+// 请求格式：先以一个字节的消息附带客户端的标准输出和标准错误描述符（SCM_RIGHTS），
+// 再发送 魔数 + 工作目录 + 参数个数 + 各参数，字段均为"长度\n内容"，发送完毕后关闭写端；
+// 回复为"退出码\n"
+const char kRequestMagic[] = "C-COMPILER-SERVER 1\n";
+
+void appendField(std::string& out, const std::string& field) {
+    out += std::to_string(field.size());
+    out += '\n';
+    out += field;
+}
+
+// 从data的pos处读取一个字段，格式不符时返回false
+bool readField(const std::string& data, size_t& pos, std::string& field) {
+    size_t newline = data.find('\n', pos);
+    if (newline == std::string::npos) {
+        return false;
+    }
+    char* end;
+    unsigned long long length = strtoull(data.c_str() + pos, &end, 10);
+    if (end != data.c_str() + newline || length > data.size() - newline - 1) {
+        return false;
+    }
+    field = data.substr(newline + 1, length);
+    pos = newline + 1 + length;
+    return true;
+}
+
+bool writeAll(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t written = write(fd, data, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += written;
+        size -= written;
+    }
+    return true;
+}
+
+bool readAll(int fd, std::string& data) {
+    char buffer[64 * 1024];
+    for (;;) {
+        ssize_t count = read(fd, buffer, sizeof(buffer));
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        if (count == 0) {
+            return true;
+        }
+        data.append(buffer, count);
+    }
+}
+
+bool makeAddress(const std::string& path, sockaddr_un& address) {
+    if (path.empty() || path.size() >= sizeof(address.sun_path)) {
+        return false;
+    }
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    return true;
+}
+
+// 接收一个请求；描述符收到后即写入fds，即使随后的内容不合法也由调用者关闭
+bool receiveRequest(int connection, int fds[2], std::string& directory, std::vector<std::string>& args) {
+    char tag;
+    iovec io = {&tag, 1};
+    alignas(cmsghdr) char control[CMSG_SPACE(2 * sizeof(int))];
+    msghdr message = {};
+    message.msg_iov = &io;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+    if (recvmsg(connection, &message, 0) != 1) {
+        return false;
+    }
+    cmsghdr* header = CMSG_FIRSTHDR(&message);
+    if (!header || header->cmsg_level != SOL_SOCKET || header->cmsg_type != SCM_RIGHTS ||
+        header->cmsg_len != CMSG_LEN(2 * sizeof(int))) {
+        return false;
+    }
+    memcpy(fds, CMSG_DATA(header), 2 * sizeof(int));
+
+    std::string data;
+    size_t magicLength = sizeof(kRequestMagic) - 1;
+    if (!readAll(connection, data) || data.compare(0, magicLength, kRequestMagic) != 0) {
+        return false;
+    }
+    size_t pos = magicLength;
+    if (!readField(data, pos, directory)) {
+        return false;
+    }
+    size_t newline = data.find('\n', pos);
+    char* end;
+    unsigned long argc = strtoul(data.c_str() + pos, &end, 10);
+    if (newline == std::string::npos || end != data.c_str() + newline || argc > data.size()) {
+        return false;
+    }
+    pos = newline + 1;
+    args.resize(argc);
+    for (std::string& arg : args) {
+        if (!readField(data, pos, arg)) {
+            return false;
+        }
+    }
+    return pos == data.size() && !args.empty();
+}
+
+void flushOutput() {
+    std::cout.flush();
+    std::cerr.flush();
+    fflush(stdout);
+    fflush(stderr);
+}
+
+// 在客户端的目录下执行命令，执行期间标准输出/标准错误换成客户端的描述符
+int execute(const int fds[2], const std::string& directory, const std::vector<std::string>& args,
+            const CommandHandler& handler) {
+    if (chdir(directory.c_str()) != 0) {
+        std::string message = "错误: 无法进入目录 '" + directory + "'\n";
+        writeAll(fds[1], message.data(), message.size());
+        return 1;
+    }
+
+    flushOutput();
+    int savedOut = dup(STDOUT_FILENO);
+    int savedErr = dup(STDERR_FILENO);
+    dup2(fds[0], STDOUT_FILENO);
+    dup2(fds[1], STDERR_FILENO);
+
+    int status;
+    try {
+        status = handler(args);
+    } catch (const std::exception& error) {
+        std::cerr << "错误: " << error.what() << std::endl;
+        status = 1;
+    }
+
+    // 客户端提前关闭输出时写入会失败，恢复流状态以免影响之后的请求
+    flushOutput();
+    dup2(savedOut, STDOUT_FILENO);
+    dup2(savedErr, STDERR_FILENO);
+    close(savedOut);
+    close(savedErr);
+    std::cout.clear();
+    std::cerr.clear();
+    clearerr(stdout);
+    clearerr(stderr);
+    return status;
+}
+
+void serve(int connection, const CommandHandler& handler) {
+    int fds[2] = {-1, -1};
+    std::string directory;
+    std::vector<std::string> args;
+    if (receiveRequest(connection, fds, directory, args)) {
+        std::string reply = std::to_string(execute(fds, directory, args, handler)) + "\n";
+        writeAll(connection, reply.data(), reply.size());
+    }
+    for (int fd : fds) {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+}
+
+} // namespace
+
+int runServer(const std::string& socketPath, const CommandHandler& handler) {
+    // 客户端断开后继续写入其输出时只返回错误，不终止服务
+    signal(SIGPIPE, SIG_IGN);
+
+    sockaddr_un address;
+    if (!makeAddress(socketPath, address)) {
+        std::cerr << "错误: 套接字路径无效或过长 '" << socketPath << "'" << std::endl;
+        return 1;
+    }
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0) {
+        std::cerr << "错误: 无法创建套接字: " << strerror(errno) << std::endl;
+        return 1;
+    }
+
+    // 上次未正常退出时会留下套接字文件：确认没有服务在监听后删除
+    struct stat info;
+    if (stat(socketPath.c_str(), &info) == 0 && S_ISSOCK(info.st_mode)) {
+        int probe = socket(AF_UNIX, SOCK_STREAM, 0);
+        bool alive = probe >= 0 && connect(probe, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0;
+        if (probe >= 0) {
+            close(probe);
+        }
+        if (alive) {
+            std::cerr << "错误: 已有编译服务在监听 '" << socketPath << "'" << std::endl;
+            close(listener);
+            return 1;
+        }
+        unlink(socketPath.c_str());
+    }
+
+    if (bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(listener, 64) != 0) {
+        std::cerr << "错误: 无法监听 '" << socketPath << "': " << strerror(errno) << std::endl;
+        close(listener);
+        return 1;
+    }
+    std::cerr << "编译服务已启动，监听 " << socketPath << std::endl;
+
+    // 请求在各自客户端的目录下执行，退出时按绝对路径删除套接字文件
+    std::string socketFile = socketPath;
+    char directory[PATH_MAX];
+    if (socketFile[0] != '/' && getcwd(directory, sizeof(directory))) {
+        socketFile = std::string(directory) + "/" + socketFile;
+    }
+
+    for (;;) {
+        int connection = accept(listener, nullptr, nullptr);
+        if (connection < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            std::cerr << "错误: 接受连接失败: " << strerror(errno) << std::endl;
+            break;
+        }
+        serve(connection, handler);
+        close(connection);
+    }
+    close(listener);
+    unlink(socketFile.c_str());
+    return 1;
+}
+
+int runClient(const std::string& socketPath, const std::vector<std::string>& args) {
+    signal(SIGPIPE, SIG_IGN);
+
+    sockaddr_un address;
+    char directory[PATH_MAX];
+    if (!makeAddress(socketPath, address) || !getcwd(directory, sizeof(directory))) {
+        return -1;
+    }
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        close(fd);
+        return -1;
+    }
+
+    // 先附带本进程的标准输出和标准错误，服务直接写到这里
+    char tag = 'R';
+    iovec io = {&tag, 1};
+    alignas(cmsghdr) char control[CMSG_SPACE(2 * sizeof(int))];
+    memset(control, 0, sizeof(control));
+    msghdr message = {};
+    message.msg_iov = &io;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+    cmsghdr* header = CMSG_FIRSTHDR(&message);
+    header->cmsg_level = SOL_SOCKET;
+    header->cmsg_type = SCM_RIGHTS;
+    header->cmsg_len = CMSG_LEN(2 * sizeof(int));
+    int fds[2] = {STDOUT_FILENO, STDERR_FILENO};
+    memcpy(CMSG_DATA(header), fds, sizeof(fds));
+
+    std::string request = kRequestMagic;
+    appendField(request, directory);
+    request += std::to_string(args.size()) + "\n";
+    for (const std::string& arg : args) {
+        appendField(request, arg);
+    }
+
+    std::string reply;
+    bool sent = sendmsg(fd, &message, 0) == 1 && writeAll(fd, request.data(), request.size()) &&
+                shutdown(fd, SHUT_WR) == 0;
+    bool replied = sent && readAll(fd, reply) && !reply.empty() && reply.back() == '\n';
+    close(fd);
+    if (!replied) {
+        std::cerr << "错误: 编译服务未返回结果" << std::endl;
+        return 1;
+    }
+    return atoi(reply.c_str());
+}
+
+#else
+
+int runServer(const std::string& socketPath, const CommandHandler& handler) {
+    (void)socketPath;
+    (void)handler;
+    std::cerr << "错误: 当前平台不支持编译服务" << std::endl;
+    return 1;
+}
+
+int runClient(const std::string& socketPath, const std::vector<std::string>& args) {
+    (void)socketPath;
+    (void)args;
+    return -1;
+}
+
+#endif
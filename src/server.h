@@ -0,0 +1,23 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <functional>
+#include <string>
+#include <vector>
+
+// 编译服务：常驻进程在Unix域套接字上逐个接受请求，省去每次编译的进程启动开销，
+// 驻留表、内存池的空闲块和编译缓存等进程内状态在请求之间保留。
+// 一个请求即一条完整的命令行：客户端把自己的标准输出/标准错误（文件描述符）、
+// 当前目录和参数发给服务，服务在该目录下执行命令，汇编和诊断信息直接写到客户端的输出上，
+// 最后回送退出码。请求依次处理（命令本身仍可用 -j 并行）
+
+// 执行一条命令行（args[0]为程序名），返回退出码
+using CommandHandler = std::function<int(const std::vector<std::string>& args)>;
+
+// 在socketPath上监听并处理请求，直到出错退出；返回进程退出码
+int runServer(const std::string& socketPath, const CommandHandler& handler);
+
+// 把命令行发给socketPath上的服务执行，返回命令的退出码；无法连接服务时返回-1
+int runClient(const std::string& socketPath, const std::vector<std::string>& args);
+
+#endif // SERVER_H
@@ -0,0 +1,103 @@
+#include "source.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+SourceBuffer::~SourceBuffer() {
+#ifndef _WIN32
+    if (mappedBytes != 0) {
+        munmap(base, mappedBytes);
+        return;
+    }
+#endif
+    free(base);
+}
+
+std::unique_ptr<SourceBuffer> SourceBuffer::open(const std::string& path) {
+    std::unique_ptr<SourceBuffer> source(new SourceBuffer());
+#ifndef _WIN32
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return nullptr;
+    }
+    struct stat info;
+    bool mapped = fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0 &&
+                  source->map(fd, static_cast<size_t>(info.st_size));
+    close(fd);
+    if (mapped) {
+        return source;
+    }
+#endif
+    if (!source->read(path)) {
+        return nullptr;
+    }
+    return source;
+}
+
+bool SourceBuffer::map(int fd, size_t size) {
+#ifndef _WIN32
+    // 先保留一段足以容纳内容和两个'\0'的匿名区域，再把文件映射到其开头：
+    // 文件最后一页中超出文件长度的部分由内核填零；文件恰好占满整页时，
+    // 末尾的'\0'落在后面的匿名页中，同样为零
+    size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t total = (size + 2 + page - 1) / page * page;
+    void* region = mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (region == MAP_FAILED) {
+        return false;
+    }
+    void* file = mmap(region, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, 0);
+    if (file == MAP_FAILED) {
+        munmap(region, total);
+        return false;
+    }
+    madvise(region, total, MADV_SEQUENTIAL);
+    base = static_cast<char*>(region);
+    length = size;
+    mappedBytes = total;
+    return true;
+#else
+    (void)fd;
+    (void)size;
+    return false;
+#endif
+}
+
+bool SourceBuffer::read(const std::string& path) {
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file) {
+        return false;
+    }
+    size_t capacity = 64 * 1024;
+    size_t size = 0;
+    char* buffer = static_cast<char*>(malloc(capacity + 2));
+    while (buffer) {
+        size += fread(buffer + size, 1, capacity - size, file);
+        if (size < capacity) {
+            break;
+        }
+        capacity *= 2;
+        char* grown = static_cast<char*>(realloc(buffer, capacity + 2));
+        if (!grown) {
+            free(buffer);
+        }
+        buffer = grown;
+    }
+    bool ok = buffer && !ferror(file);
+    fclose(file);
+    if (!ok) {
+        free(buffer);
+        return false;
+    }
+    buffer[size] = '\0';
+    buffer[size + 1] = '\0';
+    base = buffer;
+    length = size;
+    return true;
+}
@@ -0,0 +1,51 @@
+#ifndef SOURCE_H
+#define SOURCE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+// 词法单元：只记录词素在源文件缓冲区中的位置，不复制词素
+struct TokenView {
+    int kind;
+    int line;
+    uint32_t offset;
+    uint32_t length;
+};
+
+// 源文件缓冲区：整个文件映射（mmap）到内存，词法分析器直接在其上扫描。
+// 内容之后紧跟两个'\0'，满足Flex yy_scan_buffer 的要求；
+// 不支持mmap的平台或映射失败时退化为一次性读入堆内存。
+// 缓冲区可写（私有映射，写时复制）：Flex会临时在词素末尾写入'\0'。
+class SourceBuffer {
+private:
+    char* base;
+    size_t length;          // 文件内容字节数（不含末尾的两个'\0'）
+    size_t mappedBytes;     // 映射区域大小，0表示内容在堆上
+
+    SourceBuffer() : base(nullptr), length(0), mappedBytes(0) {}
+
+    bool map(int fd, size_t size);
+    bool read(const std::string& path);
+
+public:
+    ~SourceBuffer();
+    SourceBuffer(const SourceBuffer&) = delete;
+    SourceBuffer& operator=(const SourceBuffer&) = delete;
+
+    // 打开并映射源文件，失败时返回nullptr
+    static std::unique_ptr<SourceBuffer> open(const std::string& path);
+
+    char* data() { return base; }
+    const char* data() const { return base; }
+    size_t size() const { return length; }
+    bool isMapped() const { return mappedBytes != 0; }
+
+    std::string_view text(const TokenView& token) const {
+        return std::string_view(base + token.offset, token.length);
+    }
+};
+
+#endif // SOURCE_H
@@ -0,0 +1,308 @@
+#include "ssa.h"
+#include <algorithm>
+#include <functional>
+
+// DominatorTree 实现
+DominatorTree::DominatorTree(const IRFunction& func)
+    : idom(func.blocks.size(), -1), childBlocks(func.blocks.size()), frontiers(func.blocks.size()) {
+    int blockCount = func.blocks.size();
+
+    // 非递归DFS求后序
+    std::vector<int> postorder;
+    std::vector<bool> visited(blockCount, false);
+    std::vector<std::pair<int, size_t>> stack = {{0, 0}};
+    visited[0] = true;
+    while (!stack.empty()) {
+        auto& top = stack.back();
+        const auto& succs = func.blocks[top.first].succs;
+        if (top.second < succs.size()) {
+            int succ = succs[top.second++];
+            if (!visited[succ]) {
+                visited[succ] = true;
+                stack.emplace_back(succ, 0);
+            }
+        } else {
+            postorder.push_back(top.first);
+            stack.pop_back();
+        }
+    }
+    order.assign(postorder.rbegin(), postorder.rend());
+
+    std::vector<int> postIndex(blockCount, -1);
+    for (size_t i = 0; i < postorder.size(); i++) {
+        postIndex[postorder[i]] = i;
+    }
+    auto intersect = [&](int a, int b) {
+        while (a != b) {
+            while (postIndex[a] < postIndex[b]) {
+                a = idom[a];
+            }
+            while (postIndex[b] < postIndex[a]) {
+                b = idom[b];
+            }
+        }
+        return a;
+    };
+
+    idom[0] = 0;
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (int block : order) {
+            if (block == 0) {
+                continue;
+            }
+            int newIdom = -1;
+            for (int pred : func.blocks[block].preds) {
+                if (idom[pred] >= 0) {
+                    newIdom = newIdom < 0 ? pred : intersect(pred, newIdom);
+                }
+            }
+            if (newIdom != idom[block]) {
+                idom[block] = newIdom;
+                changed = true;
+            }
+        }
+    }
+
+    for (int block : order) {
+        if (block != 0) {
+            childBlocks[idom[block]].push_back(block);
+        }
+    }
+
+    // 汇合点沿各前驱向上走到其直接支配者为止，途经的块的支配边界都包含它
+    for (int block = 0; block < blockCount; block++) {
+        const auto& preds = func.blocks[block].preds;
+        if (preds.size() < 2 || idom[block] < 0) {
+            continue;
+        }
+        for (int pred : preds) {
+            for (int runner = pred; runner != idom[block] && idom[runner] >= 0; runner = idom[runner]) {
+                auto& df = frontiers[runner];
+                if (std::find(df.begin(), df.end(), block) == df.end()) {
+                    df.push_back(block);
+                }
+            }
+        }
+    }
+}
+
+bool DominatorTree::dominates(int a, int b) const {
+    while (b != a && b != 0) {
+        b = idom[b];
+    }
+    return b == a;
+}
+
+// SSA构造
+void constructSSA(IRFunction& func) {
+    int blockCount = func.blocks.size();
+    int originalCount = func.vregCount;
+
+    std::vector<int> defCount(originalCount, 0);
+    std::vector<std::vector<int>> defBlocks(originalCount);
+    for (int b = 0; b < blockCount; b++) {
+        for (const auto& instr : func.blocks[b].instrs) {
+            if (instr.dst >= 0) {
+                defCount[instr.dst]++;
+                if (defBlocks[instr.dst].empty() || defBlocks[instr.dst].back() != b) {
+                    defBlocks[instr.dst].push_back(b);
+                }
+            }
+        }
+    }
+    // 临时值只定义一次且定义支配所有使用，本身已满足SSA
+    std::vector<bool> renamed(originalCount, false);
+    for (int v = 0; v < originalCount; v++) {
+        renamed[v] = !func.vregNames[v].empty() || defCount[v] > 1;
+    }
+
+    // 在迭代支配边界上放置phi
+    DominatorTree domTree(func);
+    std::vector<std::vector<int>> phiVars(blockCount);  // 各块phi对应的原变量
+    std::vector<int> hasPhi(blockCount, -1), queued(blockCount, -1);
+    for (int v = 0; v < originalCount; v++) {
+        if (!renamed[v]) {
+            continue;
+        }
+        std::vector<int> worklist = defBlocks[v];
+        for (int b : worklist) {
+            queued[b] = v;
+        }
+        while (!worklist.empty()) {
+            int b = worklist.back();
+            worklist.pop_back();
+            for (int f : domTree.frontier(b)) {
+                if (hasPhi[f] == v) {
+                    continue;
+                }
+                hasPhi[f] = v;
+                phiVars[f].push_back(v);
+                if (queued[f] != v) {
+                    queued[f] = v;
+                    worklist.push_back(f);
+                }
+            }
+        }
+    }
+    for (int b = 0; b < blockCount; b++) {
+        auto& block = func.blocks[b];
+        std::vector<IRInstr> phis;
+        for (int v : phiVars[b]) {
+            phis.emplace_back(IROp::Phi, v, func.phiInputs.size(), block.preds.size());
+            for (int pred : block.preds) {
+                func.phiInputs.push_back({pred, -1});
+            }
+        }
+        block.instrs.insert(block.instrs.begin(), phis.begin(), phis.end());
+    }
+
+    // 未初始化变量的使用统一读取入口处的常量0
+    int undef = func.newVReg();
+    auto& entry = func.blocks[0].instrs;
+    size_t paramEnd = 0;
+    while (paramEnd < entry.size() && entry[paramEnd].op == IROp::Param) {
+        paramEnd++;
+    }
+    entry.insert(entry.begin() + paramEnd, IRInstr(IROp::Const, undef, -1, -1, 0));
+
+    // 沿支配树重命名：每个定义得到新的虚拟寄存器
+    std::vector<std::vector<int>> stacks(originalCount);
+    auto current = [&](int v) { return stacks[v].empty() ? undef : stacks[v].back(); };
+    std::function<void(int)> rename = [&](int b) {
+        std::vector<int> pushed;
+        for (auto& instr : func.blocks[b].instrs) {
+            if (instr.op != IROp::Phi) {
+                forEachUseRef(func, instr, [&](int& v) {
+                    if (v < originalCount && renamed[v]) {
+                        v = current(v);
+                    }
+                });
+            }
+            if (instr.dst >= 0 && instr.dst < originalCount && renamed[instr.dst]) {
+                int original = instr.dst;
+                instr.dst = func.newVReg(func.vregNames[original]);
+                stacks[original].push_back(instr.dst);
+                pushed.push_back(original);
+            }
+        }
+        for (int succ : func.blocks[b].succs) {
+            const auto& instrs = func.blocks[succ].instrs;
+            for (size_t k = 0; k < phiVars[succ].size(); k++) {
+                const IRInstr& phi = instrs[k];
+                for (int i = 0; i < phi.b; i++) {
+                    PhiInput& input = func.phiInputs[phi.a + i];
+                    if (input.block == b) {
+                        input.value = current(phiVars[succ][k]);
+                    }
+                }
+            }
+        }
+        for (int child : domTree.children(b)) {
+            rename(child);
+        }
+        for (int v : pushed) {
+            stacks[v].pop_back();
+        }
+    };
+    rename(0);
+}
+
+// SSA析构
+void destructSSA(IRFunction& func) {
+    int originalCount = func.blocks.size();
+    auto hasPhi = [&](int b) {
+        const auto& instrs = func.blocks[b].instrs;
+        return !instrs.empty() && instrs[0].op == IROp::Phi;
+    };
+
+    // 拆分关键边：复制只能放在仅有一个后继的前驱末尾
+    std::vector<std::vector<int>> splitBefore(originalCount);
+    for (int b = 0; b < originalCount; b++) {
+        if (!hasPhi(b)) {
+            continue;
+        }
+        std::vector<int> preds = func.blocks[b].preds;
+        for (int pred : preds) {
+            if (func.blocks[pred].succs.size() < 2) {
+                continue;
+            }
+            int split = func.blocks.size();
+            func.blocks.emplace_back("split");
+            func.blocks[split].instrs.emplace_back(IROp::Jump);
+            func.blocks[split].succs = {b};
+            func.blocks[split].preds = {pred};
+            std::replace(func.blocks[pred].succs.begin(), func.blocks[pred].succs.end(), b, split);
+            std::replace(func.blocks[b].preds.begin(), func.blocks[b].preds.end(), pred, split);
+            for (const auto& instr : func.blocks[b].instrs) {
+                for (int i = 0; instr.op == IROp::Phi && i < instr.b; i++) {
+                    PhiInput& input = func.phiInputs[instr.a + i];
+                    if (input.block == pred) {
+                        input.block = split;
+                    }
+                }
+            }
+            splitBefore[b].push_back(split);
+        }
+    }
+
+    // 每个前驱末尾插入一组并行复制，按依赖顺序展开，成环时借助新临时值
+    for (int b = 0; b < originalCount; b++) {
+        if (!hasPhi(b)) {
+            continue;
+        }
+        auto& instrs = func.blocks[b].instrs;
+        for (int pred : func.blocks[b].preds) {
+            std::vector<std::pair<int, int>> pending;  // (目标, 源)
+            for (const auto& instr : instrs) {
+                for (int i = 0; instr.op == IROp::Phi && i < instr.b; i++) {
+                    const PhiInput& input = func.phiInputs[instr.a + i];
+                    if (input.block == pred && input.value != instr.dst) {
+                        pending.emplace_back(instr.dst, input.value);
+                    }
+                }
+            }
+
+            std::vector<IRInstr> copies;
+            while (!pending.empty()) {
+                bool progress = false;
+                for (size_t i = 0; i < pending.size(); i++) {
+                    int dst = pending[i].first;
+                    bool blocked = std::any_of(pending.begin(), pending.end(),
+                                               [&](const std::pair<int, int>& move) { return move.second == dst; });
+                    if (!blocked) {
+                        copies.emplace_back(IROp::Copy, dst, pending[i].second);
+                        pending.erase(pending.begin() + i);
+                        progress = true;
+                        break;
+                    }
+                }
+                if (!progress) {
+                    int dst = pending[0].first;
+                    int temp = func.newVReg();
+                    copies.emplace_back(IROp::Copy, temp, dst);
+                    for (auto& move : pending) {
+                        if (move.second == dst) {
+                            move.second = temp;
+                        }
+                    }
+                }
+            }
+            auto& predInstrs = func.blocks[pred].instrs;
+            predInstrs.insert(predInstrs.end() - 1, copies.begin(), copies.end());
+        }
+        instrs.erase(std::remove_if(instrs.begin(), instrs.end(),
+                                    [](const IRInstr& instr) { return instr.op == IROp::Phi; }),
+                     instrs.end());
+    }
+    func.phiInputs.clear();
+
+    // 拆分出的块紧挨在目标块之前，顺序落入目标块
+    std::vector<int> order;
+    for (int b = 0; b < originalCount; b++) {
+        order.insert(order.end(), splitBefore[b].begin(), splitBefore[b].end());
+        order.push_back(b);
+    }
+    func.reorderBlocks(order);
+}
@@ -0,0 +1,32 @@
+#ifndef SSA_H
+#define SSA_H
+
+#include "ir.h"
+#include <vector>
+
+// 支配树（Cooper-Harvey-Kennedy迭代算法）与支配边界
+class DominatorTree {
+private:
+    std::vector<int> idom;                      // 直接支配者，入口块为自身
+    std::vector<int> order;                     // 逆后序
+    std::vector<std::vector<int>> childBlocks;  // 支配树子节点
+    std::vector<std::vector<int>> frontiers;    // 支配边界
+
+public:
+    explicit DominatorTree(const IRFunction& func);
+
+    int immediateDominator(int block) const { return idom[block]; }
+    bool dominates(int a, int b) const;
+    const std::vector<int>& children(int block) const { return childBlocks[block]; }
+    const std::vector<int>& frontier(int block) const { return frontiers[block]; }
+    const std::vector<int>& reversePostorder() const { return order; }
+};
+
+// 构造SSA：在迭代支配边界上放置phi，再沿支配树重命名。
+// 有名字的变量和被多次定义的虚拟寄存器都会被重命名，未初始化的使用读到常量0。
+void constructSSA(IRFunction& func);
+
+// 析构SSA：拆分通往phi所在块的关键边，把phi改写为前驱末尾的顺序化并行复制
+void destructSSA(IRFunction& func);
+
+#endif // SSA_H
@@ -0,0 +1,27 @@
+#include "types.h"
+#include <deque>
+
+namespace {
+
+// 全局类型表：前几项是内置类型，顺序与TypeKind一致
+std::deque<TypeDesc>& table() {
+    static std::deque<TypeDesc> types = {
+        {TypeKind::None,   0, ""},
+        {TypeKind::Void,   TypeId::Valid, "void"},
+        {TypeKind::Int,    TypeId::Valid | TypeId::Numeric | TypeId::Integer, "int"},
+        {TypeKind::Char,   TypeId::Valid | TypeId::Numeric | TypeId::Integer, "char"},
+        {TypeKind::Float,  TypeId::Valid | TypeId::Numeric, "float"},
+        {TypeKind::Double, TypeId::Valid | TypeId::Numeric, "double"},
+    };
+    return types;
+}
+
+} // namespace
+
+const TypeDesc& TypeId::desc() const {
+    return table()[id];
+}
+
+const std::string& typeName(TypeKind type) {
+    return TypeId(type).name();
+}
@@ -0,0 +1,62 @@
+#ifndef TYPES_H
+#define TYPES_H
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+// 基本类型（None表示尚未确定或无效）
+enum class TypeKind : unsigned char {
+    None, Void, Int, Char, Float, Double
+};
+
+// 类型表中的一项；flags 为预先算好的性质位
+struct TypeDesc {
+    TypeKind kind;
+    uint8_t flags;
+    std::string name;
+};
+
+// 类型编号：全局类型表的下标，只占两个字节。
+// 内置类型的编号与TypeKind取值相同，以后的指针、数组、结构体类型在表中追加登记。
+// 合法、数值、整数等性质存成位掩码，类型判断只需一次按位与。
+// 默认构造不初始化（保持平凡类型以便放入Bison的%union），需要无效类型时用 TypeKind::None。
+class TypeId {
+private:
+    uint16_t id;
+
+public:
+    enum Flag : uint8_t {
+        Valid   = 1 << 0,
+        Numeric = 1 << 1,
+        Integer = 1 << 2
+    };
+
+    TypeId() = default;
+    constexpr TypeId(TypeKind kind) : id(static_cast<uint16_t>(kind)) {}
+
+    const TypeDesc& desc() const;
+    TypeKind kind() const { return desc().kind; }
+    uint8_t flags() const { return desc().flags; }
+    const std::string& name() const { return desc().name; }  // None 为空串
+    uint16_t index() const { return id; }
+
+    bool isValid() const { return flags() & Valid; }
+    bool isNumeric() const { return flags() & Numeric; }
+    bool isInteger() const { return flags() & Integer; }
+
+    // 同一类型或数值类型之间（允许隐式转换）可以赋值
+    bool canAssignTo(TypeId target) const {
+        return (id == target.id && isValid()) || (flags() & target.flags() & Numeric);
+    }
+
+    bool operator==(TypeId other) const { return id == other.id; }
+    bool operator!=(TypeId other) const { return id != other.id; }
+};
+
+const std::string& typeName(TypeKind type);  // None 为空串
+
+inline std::ostream& operator<<(std::ostream& out, TypeId type) { return out << type.name(); }
+inline std::ostream& operator<<(std::ostream& out, TypeKind type) { return out << typeName(type); }
+
+#endif // TYPES_H
@@ -0,0 +1,29 @@
+// 测试用例10: 寄存器压力下的溢出（换出的活跃区间需要在整个区间内空闲的栈槽）
+int h(int a, int b) {
+    return a - b + 3;
+}
+
+int press(int p) {
+    int v0 = p + 8;
+    int v1 = p + 6;
+    int v2 = p + 5;
+    int v3 = p + 3;
+    int v4 = p + 3;
+    int v5 = p + 1;
+    int v6 = p + 6;
+    int v7 = p + 9;
+    v0 = h(v0, v2) + v6;
+    v1 = h(v1, v2) + v6;
+    v2 = h(v2, v5) + v0;
+    v3 = h(v3, v6) + v7;
+    v4 = h(v4, v7) + v1;
+    v5 = h(v5, v6) + v3;
+    v6 = h(v6, v0) + v4;
+    v7 = h(v7, v1) + v3;
+    return (v0 - v2 / 3) + (v1 - v3 / 3) + (v2 - v0 / 3) + (v3 - v1 / 3)
+         + (v4 - v2 / 3) + (v5 - v1 / 3) + (v6 - v6 / 3) + (v7 - v1 / 3);
+}
+
+int main() {
+    return press(10);
+}
@@ -0,0 +1,14 @@
+// 测试用例7: 函数调用与参数传递
+int square(int x) {
+    return x * x;
+}
+
+int weighted(int a, int b, int c, int d, int e, int f, int g, int h) {
+    return a + b + c + d + e + f + g * 2 + h * 3;
+}
+
+int main() {
+    int n = 3;
+    int r = weighted(1, 2, 3, 4, 5, 6, square(n), n + 1);
+    return r;  // 1+2+3+4+5+6 + 9*2 + 4*3 = 51
+}
@@ -0,0 +1,9 @@
+// 测试用例8: 常量折叠与2的幂乘除
+int mix(int a, int b) {
+    return a / 4 + b / 4 + a % 4 + b % 8 + b * 8 + a * 1 + 0;
+}
+
+int main() {
+    int k = (2 + 3) * 4 - 10 / 2;  // 编译期折叠为15
+    return mix(0 - 7, 13) + k;     // (-1) + 3 + (-3) + 5 + 104 + (-7) + 15 = 116
+}
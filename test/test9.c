@@ -0,0 +1,18 @@
+// 测试用例9: 循环旋转、循环不变量外提与归纳变量强度削减
+int scale(int n, int k) {
+    int s = 0;
+    int i = 0;
+    while (i < n) {
+        s = s + i * k + (k * 3 + 1) / 7;  // i * k 改为每次迭代加k，(k*3+1)/7 外提到循环前
+        i = i + 1;
+    }
+    return s;
+}
+
+int main() {
+    int total = 0;
+    for (int j = 4; j > 0; j = j - 1) {
+        total = total + scale(j, 5) + j * 2;
+    }
+    return total;
+}